@@ -0,0 +1,33 @@
+#ifndef CHESS_TUI_ANALYSIS_HPP
+#define CHESS_TUI_ANALYSIS_HPP
+#include <iostream>
+#include <vector>
+
+#include "chess-tui/board.hpp"
+#include "chess-tui/nnue.hpp"
+
+struct AnalysisOptions
+{
+    int depth = 5;
+    int multi_pv = 3;
+    // 0 uses one worker per hardware thread
+    unsigned threads = 0;
+    size_t hash_megabytes = 64;
+    // Handcrafted evaluation if not set
+    const NnueNetwork *network = nullptr;
+};
+
+/**
+ * Game record: the moves played from the initial position in the input format of convertMove,
+ * separated by whitespace
+ */
+void writeGameRecord(const Board &board, std::ostream &out);
+std::vector<Move> readGameRecord(std::istream &in);
+
+/**
+ * Evaluates every position of the game on a pool of workers sharing one transposition table
+ * and prints an annotated report. Throws std::invalid_argument on illegal moves in the record.
+ */
+void analyzeGame(const std::vector<Move> &moves, const AnalysisOptions &options, std::ostream &out);
+
+#endif //CHESS_TUI_ANALYSIS_HPP
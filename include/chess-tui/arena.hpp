@@ -0,0 +1,39 @@
+#ifndef CHESS_TUI_ARENA_HPP
+#define CHESS_TUI_ARENA_HPP
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+/**
+ * Lifetime of transient data on this thread's scratch arena: move lists, PV lines, analysis buffers.
+ * The arena is a monotonic buffer over a fixed block per thread, allocating from it is a pointer bump and nothing
+ * is freed on its own. Everything is released at once when the outermost scope on the thread ends, nested scopes
+ * (a search started by an analysis) share its lifetime. Only a full block falls back to the global heap.
+ */
+class ScratchScope
+{
+public:
+    static constexpr size_t block_size = 1 << 20;
+
+    ScratchScope();
+    ~ScratchScope();
+
+    ScratchScope(const ScratchScope &) = delete;
+    ScratchScope &operator=(const ScratchScope &) = delete;
+
+    [[nodiscard]] std::pmr::memory_resource *resource() const;
+};
+
+#ifdef CHESS_TUI_COUNT_ALLOCATIONS
+inline constexpr bool counting_allocations = true;
+#else
+inline constexpr bool counting_allocations = false;
+#endif
+
+/**
+ * Calls of the global operator new so far, on all threads. Only counted in builds with
+ * CHESS_TUI_COUNT_ALLOCATIONS (see counting_allocations), always 0 otherwise.
+ */
+uint64_t global_allocation_count();
+
+#endif //CHESS_TUI_ARENA_HPP
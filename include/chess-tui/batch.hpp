@@ -0,0 +1,54 @@
+#ifndef CHESS_TUI_BATCH_HPP
+#define CHESS_TUI_BATCH_HPP
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "chess-tui/board.hpp"
+#include "chess-tui/move-generator.hpp"
+#include "chess-tui/nnue.hpp"
+
+enum class BatchQuery {
+    LEGAL_MOVES = 0,
+    GAME_STATE = 1,
+    BEST_MOVE = 2,
+};
+
+struct BatchOptions
+{
+    BatchQuery query = BatchQuery::LEGAL_MOVES;
+    // Search depth of BEST_MOVE
+    int depth = 4;
+    // 0 uses one worker per hardware thread
+    unsigned threads = 0;
+    size_t hash_megabytes = 64;
+    // Handcrafted evaluation if not set
+    const NnueNetwork *network = nullptr;
+};
+
+/**
+ * Answer for one position. state is always set, legal_moves only for LEGAL_MOVES,
+ * best_move and score (side to move's view) only for BEST_MOVE. Without legal moves best_move stays empty.
+ */
+struct BatchResult
+{
+    GameState state = GameState::ONGOING;
+    std::vector<Move> legal_moves;
+    Move best_move;
+    int score = 0;
+};
+
+/**
+ * Answers the same query for many positions in one call, spread over a pool of workers
+ * (BEST_MOVE searches share one transposition table). The boards are only borrowed, every board
+ * is back in its original position afterwards. results[i] belongs to positions[i].
+ */
+std::vector<BatchResult> query_positions(std::vector<Board> &positions, const BatchOptions &options);
+
+/**
+ * Same for FEN strings, e.g. one per line of a file. Throws std::invalid_argument naming the first invalid FEN
+ * before any work is done.
+ */
+std::vector<BatchResult> query_positions(const std::vector<std::string> &fens, const BatchOptions &options);
+
+#endif //CHESS_TUI_BATCH_HPP
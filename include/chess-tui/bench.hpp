@@ -0,0 +1,49 @@
+#ifndef CHESS_TUI_BENCH_HPP
+#define CHESS_TUI_BENCH_HPP
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+
+#include "chess-tui/nnue.hpp"
+#include "chess-tui/search.hpp"
+
+struct BenchOptions
+{
+    int depth = 7;
+    size_t hash_megabytes = 64;
+    // Handcrafted evaluation if not set
+    const NnueNetwork *network = nullptr;
+};
+
+/**
+ * Time to depth: searches a fixed set of positions to options.depth on one thread, once without any
+ * selective technique, once with each of them alone and once with all of them, and prints nodes and time per run.
+ */
+void run_benchmark(const BenchOptions &options, std::ostream &out);
+
+struct MatchOptions
+{
+    // Every opening is played twice with colors swapped, so an odd count is rounded up
+    int games = 20;
+    std::chrono::milliseconds move_time{100};
+    Selectivity challenger;
+    Selectivity baseline = Selectivity::none();
+    size_t hash_megabytes = 16;
+    const NnueNetwork *network = nullptr;
+};
+
+struct MatchScore
+{
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+};
+
+/**
+ * Plays the challenger against the baseline at a fixed time per move from the benchmark positions,
+ * prints every game result and returns the score from the challenger's view. Games are adjudicated
+ * as draws after 300 plies.
+ */
+MatchScore run_match(const MatchOptions &options, std::ostream &out);
+
+#endif //CHESS_TUI_BENCH_HPP
@@ -3,7 +3,10 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "chess-tui/color.hpp"
+#include "chess-tui/square-set.hpp"
 #include "chess-tui/vector.hpp"
 #include "chess-tui/piece.hpp"
 
@@ -14,13 +17,41 @@ struct Move
   BoardPos from = {};
   BoardPos to = {};
   int castling = 0; // 0 is no castling, 1 is short castling, 2 is long castling
+  char promotion = 0; // Symbol of the piece a pawn promotes to (Q, R, B, N), 0 otherwise
   bool store_game = false;
   bool load_game = false;
+  bool undo = false; // take back the last move (of both sides against a bot)
+  bool redo = false;
+  bool explore = false; // show the opening explorer statistics of the current position
 
-  Move(BoardPos from, BoardPos to);
+  Move(BoardPos from, BoardPos to, char promotion = 0);
   explicit Move(int castling);
   explicit Move(bool load_game);
   Move();
+
+  bool operator==(const Move &other) const = default;
+
+  // One of the commands convertMove accepts instead of a move
+  [[nodiscard]] bool isCommand() const {
+    return this->store_game || this->load_game || this->undo || this->redo || this->explore;
+  }
+};
+
+/**
+ * Everything needed to take back a move, one entry per ply on Board::history
+ */
+struct UndoInfo
+{
+  Move move{};
+  std::shared_ptr<Piece> captured{};
+  bool moved_before = false;      // has_moved of the moving piece (the king when castling)
+  bool rook_moved_before = false; // has_moved of the rook when castling
+  uint64_t hash = 0;              // position hash before the move
+  uint64_t pawn_hash = 0;         // pawn hash before the move
+  uint16_t halfmove_clock = 0;    // halfmove clock before the move
+  BoardPos en_passant = {-1, -1}; // en passant square before the move
+  bool en_passant_capture = false;
+  std::shared_ptr<Piece> promoted_pawn{};
 };
 
 struct Board
@@ -29,12 +60,72 @@ struct Board
   std::array<std::shared_ptr<Rook>, 4> initial_rooks;
   std::array<std::array<std::shared_ptr<Piece>, 8>, 8> grid;
 
+  bool white_to_move = true;
+  // Square a pawn can capture en passant onto, {-1, -1} if there is none
+  BoardPos en_passant = {-1, -1};
+  uint64_t hash = 0;
+  // Zobrist key of the pawns and kings only, identifies the pawn structure for the pawn cache
+  uint64_t pawn_hash = 0;
+  // Plies since the last capture or pawn move
+  uint16_t halfmove_clock = 0;
+  std::vector<UndoInfo> history;
+  // Pieces of promotions that were taken back, handed out again by the next promotion to the same piece,
+  // so a search does not allocate a piece for every promotion it tries
+  std::vector<std::shared_ptr<Piece>> spare_pieces;
+
   Board();
   explicit Board(const std::vector<std::shared_ptr<Piece>> &pieces);
 
   void movePiece(const BoardPos &from, const BoardPos &to);
 
-  void draw(const std::set<BoardPos> &marked_cells) const;
+  /**
+   * Executes a legal move (including castling) for the side to move and pushes it onto history
+   */
+  void makeMove(const Move &move);
+  void unmakeMove();
+  template<Color Us> void makeMove(const Move &move);
+  template<Color Us> void unmakeMove();
+
+  /**
+   * Passes the turn, for null-move pruning in the search. Pushes an entry without a move onto history
+   * and resets the halfmove clock, so repetitions are not looked for across it.
+   */
+  void makeNullMove();
+  void unmakeNullMove();
+
+  /**
+   * Drops the move history and recomputes the hashes, e.g. after loading a position
+   */
+  void resetHistory();
+
+  /**
+   * Piece placement in the binary format described in the README. Reading replaces all pieces,
+   * registers the kings and every unmoved rook on its home corner as initial rook, and resets the history.
+   * Throws std::invalid_argument on invalid data.
+   */
+  void writePieces(std::ostream &out) const;
+  void readPieces(std::istream &in);
+
+  /**
+   * Replaces the position with a FEN. Missing fields after the piece placement default to white to move,
+   * no castling, no en passant. An en passant square no pawn can capture on is dropped. Throws std::invalid_argument
+   * on invalid input, including positions that cannot arise in a game: not one king per side, pawns on the first
+   * or last rank, or the side not to move in check.
+   */
+  void readFen(const std::string &fen);
+
+  [[nodiscard]] uint64_t computeHash() const;
+  [[nodiscard]] uint64_t computePawnHash() const;
+
+  /**
+   * Threefold repetition. Inside a search the first repetition of a position reached within
+   * the last search_ply plies already counts, as the side to move could repeat it again anyway.
+   */
+  [[nodiscard]] bool isRepetition(int search_ply = 0) const;
+  [[nodiscard]] bool isFiftyMoveDraw() const;
+
+  // rank_notes[y] is printed to the right of rank y + 1
+  void draw(const SquareSet &marked_cells, const std::array<std::string, 8> &rank_notes = {}) const;
 
   std::shared_ptr<Piece> &getPiece(const BoardPos &pos);
 
@@ -42,6 +133,14 @@ struct Board
 
   [[nodiscard]] BoardPos getPos(const Piece &piece) const;
 
+  /**
+   * A piece for a promotion, taken from spare_pieces if there is one not shared with another board
+   */
+  std::shared_ptr<Piece> takePromotionPiece(char symbol, bool white);
+
   [[nodiscard]] King &getKing(bool white) const;
-  [[nodiscard]] Rook &getInitialRook(bool white, bool long_side) const;
+  [[nodiscard]] Rook &getInitialRook(bool white, bool short_side) const;
+  template<Color Us> [[nodiscard]] Rook &getInitialRook(bool short_side) const {
+    return *this->initial_rooks[ColorTraits<Us>::initial_rook_index(short_side)];
+  }
 };
\ No newline at end of file
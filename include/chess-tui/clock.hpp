@@ -0,0 +1,65 @@
+#ifndef CHESS_TUI_CLOCK_HPP
+#define CHESS_TUI_CLOCK_HPP
+#include <array>
+#include <chrono>
+#include <string>
+
+/**
+ * Chess clock with increment (Fischer). Only the side to move is running.
+ */
+class GameClock
+{
+public:
+    using duration = std::chrono::milliseconds;
+
+    GameClock(duration base, duration increment);
+
+    /**
+     * Starts the clock of the given side
+     */
+    void start(bool white);
+
+    /**
+     * Stops the running clock after a move and adds the increment.
+     * Returns false if the side ran out of time before moving, its clock stays at zero then.
+     */
+    bool stop();
+
+    /**
+     * Time left of the given side, including the running period
+     */
+    [[nodiscard]] duration remaining(bool white) const;
+
+    [[nodiscard]] duration getIncrement() const;
+
+    /**
+     * Parses "minutes+increment seconds", e.g. "3+2". Throws std::invalid_argument.
+     */
+    static GameClock parse(const std::string &time_control);
+
+private:
+    std::array<duration, 2> left;
+    duration increment;
+    bool running = false;
+    bool running_white = true;
+    std::chrono::steady_clock::time_point started;
+};
+
+/**
+ * Search time for one move: the soft limit is the target, the search stops early below it and may extend
+ * beyond it up to the hard limit, which it never exceeds
+ */
+struct TimeBudget
+{
+    GameClock::duration soft;
+    GameClock::duration hard;
+};
+
+TimeBudget allocate_time(GameClock::duration remaining, GameClock::duration increment);
+
+/**
+ * mm:ss.t
+ */
+std::string format_clock(GameClock::duration time);
+
+#endif //CHESS_TUI_CLOCK_HPP
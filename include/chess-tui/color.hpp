@@ -0,0 +1,49 @@
+#ifndef CHESS_TUI_COLOR_HPP
+#define CHESS_TUI_COLOR_HPP
+#include <cstdint>
+
+enum class Color : uint8_t {
+    BLACK = 0,
+    WHITE = 1,
+};
+
+constexpr Color operator~(const Color color) {
+    return color == Color::WHITE ? Color::BLACK : Color::WHITE;
+}
+
+/**
+ * Everything that differs between the two sides, known at compile time.
+ * Code templated on the side to move uses these instead of branching on a white flag.
+ */
+template<Color Us>
+struct ColorTraits
+{
+    static constexpr bool white = Us == Color::WHITE;
+    static constexpr int8_t pawn_dir = white ? 1 : -1;
+    static constexpr int8_t pawn_start_rank = white ? 1 : 6;
+    static constexpr int8_t promotion_rank = white ? 7 : 0;
+    // Rank our pawns capture en passant from
+    static constexpr int8_t en_passant_rank = white ? 4 : 3;
+    static constexpr int8_t back_rank = white ? 0 : 7;
+
+    // Files of the castling squares, indexed by short_side
+    static constexpr int8_t king_from_file = 4;
+    static constexpr int8_t king_to_file[2] = {2, 6};
+    static constexpr int8_t rook_from_file[2] = {0, 7};
+    static constexpr int8_t rook_to_file[2] = {3, 5};
+
+    // Index into Board::initial_rooks
+    static constexpr uint8_t initial_rook_index(const bool short_side) {
+        return (white ? 2 : 0) + short_side;
+    }
+};
+
+inline constexpr bool to_white(const Color color) {
+    return color == Color::WHITE;
+}
+
+inline constexpr Color to_color(const bool white) {
+    return white ? Color::WHITE : Color::BLACK;
+}
+
+#endif //CHESS_TUI_COLOR_HPP
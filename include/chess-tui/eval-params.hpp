@@ -0,0 +1,88 @@
+#ifndef CHESS_TUI_EVAL_PARAMS_HPP
+#define CHESS_TUI_EVAL_PARAMS_HPP
+#include <array>
+
+/*
+ * Evaluation weights in centipawns, indexed by piece_type_index (P, N, B, R, Q, K).
+ * Piece square tables are indexed y * 8 + x from white's point of view (a1 first),
+ * black pieces look them up with the rank mirrored.
+ */
+
+inline constexpr std::array<int, 6> piece_values = {100, 320, 330, 500, 900, 0};
+
+// Pawn structure, per pawn (see PawnFeatures)
+inline constexpr int doubled_pawn = -10;
+inline constexpr int isolated_pawn = -15;
+inline constexpr std::array<int, 8> passed_pawn = {0, 5, 10, 20, 35, 60, 100, 0};
+inline constexpr int pawn_shield = 10;
+
+inline constexpr std::array<std::array<int, 64>, 6> piece_square_tables = {{
+        // Pawn
+        {
+               0,    0,    0,    0,    0,    0,    0,    0,
+               5,   10,   10,  -20,  -20,   10,   10,    5,
+               5,   -5,  -10,    0,    0,  -10,   -5,    5,
+               0,    0,    0,   20,   20,    0,    0,    0,
+               5,    5,   10,   25,   25,   10,    5,    5,
+              10,   10,   20,   30,   30,   20,   10,   10,
+              50,   50,   50,   50,   50,   50,   50,   50,
+               0,    0,    0,    0,    0,    0,    0,    0,
+        },
+        // Knight
+        {
+             -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50,
+             -40,  -20,    0,    5,    5,    0,  -20,  -40,
+             -30,    5,   10,   15,   15,   10,    5,  -30,
+             -30,    0,   15,   20,   20,   15,    0,  -30,
+             -30,    5,   15,   20,   20,   15,    5,  -30,
+             -30,    0,   10,   15,   15,   10,    0,  -30,
+             -40,  -20,    0,    0,    0,    0,  -20,  -40,
+             -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50,
+        },
+        // Bishop
+        {
+             -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20,
+             -10,    5,    0,    0,    0,    0,    5,  -10,
+             -10,   10,   10,   10,   10,   10,   10,  -10,
+             -10,    0,   10,   10,   10,   10,    0,  -10,
+             -10,    5,    5,   10,   10,    5,    5,  -10,
+             -10,    0,    5,   10,   10,    5,    0,  -10,
+             -10,    0,    0,    0,    0,    0,    0,  -10,
+             -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20,
+        },
+        // Rook
+        {
+               0,    0,    0,    5,    5,    0,    0,    0,
+              -5,    0,    0,    0,    0,    0,    0,   -5,
+              -5,    0,    0,    0,    0,    0,    0,   -5,
+              -5,    0,    0,    0,    0,    0,    0,   -5,
+              -5,    0,    0,    0,    0,    0,    0,   -5,
+              -5,    0,    0,    0,    0,    0,    0,   -5,
+               5,   10,   10,   10,   10,   10,   10,    5,
+               0,    0,    0,    0,    0,    0,    0,    0,
+        },
+        // Queen
+        {
+             -20,  -10,  -10,   -5,   -5,  -10,  -10,  -20,
+             -10,    0,    5,    0,    0,    0,    0,  -10,
+             -10,    5,    5,    5,    5,    5,    0,  -10,
+               0,    0,    5,    5,    5,    5,    0,   -5,
+              -5,    0,    5,    5,    5,    5,    0,   -5,
+             -10,    0,    5,    5,    5,    5,    0,  -10,
+             -10,    0,    0,    0,    0,    0,    0,  -10,
+             -20,  -10,  -10,   -5,   -5,  -10,  -10,  -20,
+        },
+        // King
+        {
+              20,   30,   10,    0,    0,   10,   30,   20,
+              20,   20,    0,    0,    0,    0,   20,   20,
+             -10,  -20,  -20,  -20,  -20,  -20,  -20,  -10,
+             -20,  -30,  -30,  -40,  -40,  -30,  -30,  -20,
+             -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+             -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+             -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+             -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+        },
+}};
+
+#endif //CHESS_TUI_EVAL_PARAMS_HPP
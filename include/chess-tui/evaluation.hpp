@@ -0,0 +1,12 @@
+#ifndef CHESS_TUI_EVALUATION_HPP
+#define CHESS_TUI_EVALUATION_HPP
+
+#include "chess-tui/board.hpp"
+
+/**
+ * Static evaluation in centipawns from the point of view of the side to move: material, piece square tables
+ * and pawn structure, the latter cached per thread by pawn hash
+ */
+int evaluate(Board &board);
+
+#endif //CHESS_TUI_EVALUATION_HPP
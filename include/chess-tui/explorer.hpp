@@ -0,0 +1,84 @@
+#ifndef CHESS_TUI_EXPLORER_HPP
+#define CHESS_TUI_EXPLORER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * One record of the opening index: a move played from a position and how the games continuing with it ended.
+ * The index file is a header followed by these records sorted by hash, then move, so all moves of a position
+ * are adjacent.
+ */
+struct ExplorerEntry
+{
+    // Board::hash of the position the move was played from
+    uint64_t hash;
+    // encode_move
+    uint16_t move;
+    uint16_t reserved;
+    uint32_t white_wins;
+    uint32_t draws;
+    uint32_t black_wins;
+
+    [[nodiscard]] uint64_t games() const {
+        return static_cast<uint64_t>(this->white_wins) + this->draws + this->black_wins;
+    }
+};
+static_assert(sizeof(ExplorerEntry) == 24);
+
+struct IndexBuildOptions
+{
+    // Only the first plies of every game are indexed, later positions rarely repeat between games
+    int max_plies = 40;
+    // 0 uses one worker per hardware thread
+    unsigned threads = 0;
+};
+
+struct IndexBuildStats
+{
+    uint64_t games = 0;
+    // Games without a result or with an unreadable or illegal move
+    uint64_t skipped = 0;
+    uint64_t entries = 0;
+};
+
+/**
+ * Replays the games of the archives in parallel and writes the aggregated move statistics to index_path.
+ * An archive holds one game per line: the moves from the initial position in the format of convertMove,
+ * followed by the result 1-0, 0-1 or 1/2-1/2. Throws std::runtime_error if a file cannot be read or written.
+ */
+IndexBuildStats build_opening_index(const std::vector<std::string> &archive_paths, const std::string &index_path,
+                                    const IndexBuildOptions &options);
+
+/**
+ * Read-only view of an index written by build_opening_index. The file is mapped, not loaded,
+ * a lookup is a binary search over the mapped records.
+ */
+class OpeningIndex
+{
+public:
+    /**
+     * Throws std::runtime_error if the file cannot be mapped or is not an opening index
+     */
+    explicit OpeningIndex(const std::string &path);
+    ~OpeningIndex();
+
+    OpeningIndex(const OpeningIndex &) = delete;
+    OpeningIndex &operator=(const OpeningIndex &) = delete;
+
+    /**
+     * The moves played from the position with the given hash, empty if it is not indexed
+     */
+    [[nodiscard]] std::span<const ExplorerEntry> lookup(uint64_t hash) const;
+
+    [[nodiscard]] size_t size() const { return this->entries.size(); }
+
+private:
+    void *mapping = nullptr;
+    size_t mapping_size = 0;
+    std::span<const ExplorerEntry> entries;
+};
+
+#endif //CHESS_TUI_EXPLORER_HPP
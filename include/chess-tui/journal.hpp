@@ -0,0 +1,85 @@
+#ifndef CHESS_TUI_JOURNAL_HPP
+#define CHESS_TUI_JOURNAL_HPP
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "chess-tui/board.hpp"
+
+/**
+ * Crash safe autosave with undo and redo. Every move or take back is appended to <prefix>.journal
+ * as one 2 byte record. Every snapshot_interval records the whole game (starting position, moves, redo moves)
+ * is written to <prefix>.snapshot and the journal starts over.
+ *
+ * Journal: "CTJN", u32 generation, then u16 records (encode_move, 0 = take back the last move).
+ * Snapshot: "CTSN", u32 generation, u8 white to move, the starting position (Board::writePieces),
+ * u16 move count, moves, u16 redo count, redo moves (next redo last).
+ * A journal continues the snapshot with the generation one below its own.
+ *
+ * If a file cannot be written, autosave turns itself off and the game goes on in memory only;
+ * takeWriteError reports the reason once.
+ */
+class GameJournal
+{
+public:
+    explicit GameJournal(std::string prefix = "chess");
+    ~GameJournal();
+
+    GameJournal(const GameJournal &) = delete;
+    GameJournal &operator=(const GameJournal &) = delete;
+
+    /**
+     * Restores an unfinished game from the snapshot and the journal onto board.
+     * Returns false if there is none. Throws std::runtime_error if the files are damaged.
+     */
+    bool recover(Board &board);
+
+    /**
+     * Starts a new journal with the current position of board as starting position
+     */
+    void reset(const Board &board);
+
+    /**
+     * Removes both files, e.g. once the game is over
+     */
+    void clear();
+
+    /**
+     * Plays a legal move on board and appends it. Clears the redo moves.
+     */
+    void makeMove(Board &board, const Move &move);
+
+    /**
+     * Take back the last move / play the last taken back move again. Return false if there is none.
+     */
+    bool undo(Board &board);
+    bool redo(Board &board);
+
+    [[nodiscard]] bool startsFromInitialPosition() const;
+
+    /**
+     * Why autosave was turned off, empty if it was not or if that was already reported
+     */
+    std::string takeWriteError();
+
+private:
+    void disable(const std::runtime_error &error);
+    void append(uint16_t record);
+    void writeSnapshot(const Board &board);
+    void openJournal(bool truncate);
+
+    std::string journal_path;
+    std::string snapshot_path;
+    int fd = -1;
+    bool autosave = true;
+    std::string write_error;
+    uint32_t generation = 0;
+    uint32_t records = 0;
+    uint32_t unsynced = 0;
+    // Starting position in the format of Board::writePieces
+    std::string start_position;
+    bool start_white_to_move = true;
+    std::vector<Move> redo_moves;
+};
+
+#endif //CHESS_TUI_JOURNAL_HPP
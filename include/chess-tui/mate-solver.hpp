@@ -0,0 +1,145 @@
+#ifndef CHESS_TUI_MATE_SOLVER_HPP
+#define CHESS_TUI_MATE_SOLVER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "chess-tui/board.hpp"
+#include "chess-tui/color.hpp"
+#include "chess-tui/move-generator.hpp"
+#include "chess-tui/transposition-table.hpp"
+
+/**
+ * Left uninitialized until NodeArena::allocate hands it out, so a large arena costs no time up front
+ */
+struct MateNode
+{
+    // Proof and disproof number: how many leaves still have to be proven / disproven
+    uint32_t pn;
+    uint32_t dn;
+    uint32_t first_child;
+    uint32_t next_sibling;
+    // Move leading to this node, encode_move
+    uint16_t move;
+    // Plies to mate once proven
+    uint8_t mate_plies;
+    bool expanded;
+};
+
+/**
+ * Fixed capacity node store. Nodes are addressed by 32 bit index and recycled through a free list
+ * threaded through next_sibling, so the tree never allocates after construction.
+ */
+class NodeArena
+{
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    explicit NodeArena(size_t megabytes);
+
+    /**
+     * Returns NONE once the arena is full
+     */
+    uint32_t allocate(uint16_t move);
+    // Frees a list of siblings and everything below them
+    void releaseList(uint32_t first);
+
+    MateNode &operator[](const uint32_t index) { return this->nodes[index]; }
+    [[nodiscard]] size_t used() const { return this->used_count; }
+    [[nodiscard]] size_t capacity() const { return this->node_count; }
+
+private:
+    std::unique_ptr<MateNode[]> nodes;
+    size_t node_count;
+    uint32_t free_list = NONE;
+    uint32_t untouched = 0;
+    size_t used_count = 0;
+};
+
+// Mate lengths in plies are kept in MateNode::mate_plies, with UINT8_MAX meaning none yet
+inline constexpr int MAX_MATE_MOVES = 127;
+
+enum class MateOutcome {
+    MATE = 0,
+    NO_MATE = 1,
+    // The node store ran full without reaching a result
+    UNKNOWN = 2,
+};
+
+struct MateResult
+{
+    MateOutcome outcome = MateOutcome::UNKNOWN;
+    // Number of own moves to mate against any defence. Without shortest only an upper bound,
+    // proof-number search proves whichever mate it reaches first
+    int moves = 0;
+    bool shortest = false;
+    // Mating line, starting with the side to move, the defender playing its longest known defence
+    std::vector<Move> line;
+    // False if the node store ran full before the line reached the mate, it then stops early
+    bool line_complete = false;
+    uint64_t nodes = 0;
+};
+
+/**
+ * Proves or disproves a forced mate for the side to move with proof-number search. The tree is expanded
+ * best first at its most proving node. Solved subtrees are dropped right away, their result is kept in a
+ * transposition table; when the arena runs full the deepest levels are collapsed back into leaves.
+ * The attacker's last move can only mate with check, so it is generated check-only.
+ */
+class MateSolver
+{
+public:
+    /**
+     * megabytes is split between the node arena and the transposition table
+     */
+    MateSolver(Board &board, size_t megabytes = 256);
+
+    /**
+     * Looks for a mate in at most max_moves (up to MAX_MATE_MOVES) moves. With shortest, every mate found is followed by an attempt
+     * at a shorter one until that is disproven, which costs a full refutation of the next shorter length.
+     */
+    MateResult solve(int max_moves, bool shortest = false);
+
+private:
+    /**
+     * Runs the proof-number search for a mate within remaining plies, returns false if memory ran out
+     */
+    bool prove(int remaining);
+
+    template<Color Us>
+    void descend(uint32_t index, int remaining);
+
+    template<Color Us>
+    void expand(uint32_t index, int remaining);
+
+    /**
+     * Initial proof and disproof numbers of a freshly generated node, the move leading to it already played
+     */
+    template<Color Us>
+    void evaluate(MateNode &node, int remaining);
+
+    void update(MateNode &node, bool attacker);
+    void storeResult(const MateNode &node, bool attacker, int remaining);
+    bool probeResult(MateNode &node, bool attacker, int remaining);
+
+    /**
+     * Turns the nodes of the deepest levels holding at least half of the tree back into leaves
+     */
+    bool collapse(uint32_t root);
+
+    /**
+     * Appends the mating line to line, returns false if it could not be followed up to the mate
+     */
+    bool extractLine(int plies, std::vector<Move> &line);
+
+    Board &board;
+    NodeArena arena;
+    TranspositionTable tt;
+    // Moves of the node being expanded or evaluated, per remaining plies, on the scratch arena during solve
+    MoveList *move_lists = nullptr;
+    bool out_of_memory = false;
+    uint64_t nodes = 0;
+};
+
+#endif //CHESS_TUI_MATE_SOLVER_HPP
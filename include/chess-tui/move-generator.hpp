@@ -0,0 +1,106 @@
+#ifndef CHESS_TUI_MOVE_GENERATOR_HPP
+#define CHESS_TUI_MOVE_GENERATOR_HPP
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "chess-tui/board.hpp"
+#include "chess-tui/color.hpp"
+#include "chess-tui/square-set.hpp"
+
+/**
+ * Output of the move generators. Hot callers keep one per ply on their thread's scratch arena (arena.hpp)
+ * and reuse it, reserved for MAX_MOVES, so generating never allocates.
+ */
+using MoveList = std::pmr::vector<Move>;
+// More than the legal moves of any position
+inline constexpr size_t MAX_MOVES = 256;
+
+/**
+ * Everything needed to decide whether a pseudo legal move of the side to move is legal.
+ * Computed once per position, after that a move is checked with two mask lookups.
+ */
+struct LegalityMasks
+{
+    BoardPos king_pos;
+    // Enemy pieces currently giving check
+    SquareSet checkers;
+    // Squares a non-king move has to land on: everything if not in check,
+    // the checker and the squares between it and the king in single check, nothing in double check
+    SquareSet check_mask = SquareSet::all();
+    // Own pieces that are pinned to the king
+    SquareSet pinned;
+    // For every pinned piece the line it may still move on (up to and including the pinner)
+    std::array<SquareSet, 64> pin_rays{};
+
+    [[nodiscard]] bool in_check() const { return !checkers.empty(); }
+    [[nodiscard]] bool double_check() const { return checkers.several(); }
+};
+
+enum class GameState {
+    ONGOING = 0,
+    CHECK = 1,
+    CHECKMATE = 2,
+    STALEMATE = 3,
+};
+
+/*
+ * Every query exists templated on the side to move, which is what the search calls once it knows
+ * whose turn it is, and as a runtime overload taking a white flag that dispatches to it.
+ */
+
+/**
+ * Whether a piece of color Them attacks pos. The square `ignore` is treated as empty,
+ * so that the king cannot hide from a slider on the line it is checked along.
+ */
+template<Color Them>
+bool is_attacked(Board &board, const BoardPos &pos, const BoardPos &ignore = {-1, -1});
+bool is_attacked(Board &board, const BoardPos &pos, bool by_white, const BoardPos &ignore = {-1, -1});
+
+template<Color Us>
+LegalityMasks compute_legality_masks(Board &board);
+LegalityMasks compute_legality_masks(Board &board, bool white);
+
+/**
+ * Legal destination squares of the piece on from. Castling is not included.
+ */
+template<Color Us>
+SquareSet legal_targets(Board &board, const LegalityMasks &masks, const BoardPos &from);
+SquareSet legal_targets(Board &board, const LegalityMasks &masks, const BoardPos &from);
+
+/**
+ * Returns why the given side cannot castle right now, or nullptr if castling is legal
+ */
+template<Color Us>
+const char *castling_rejection(Board &board, bool short_side);
+const char *castling_rejection(Board &board, bool white, bool short_side);
+
+/**
+ * Returns why a move entered for the side to move is not legal, or nullptr if it is.
+ * masks belong to the current position. Fills in a queen for a pawn reaching the last rank without a promotion piece.
+ */
+const char *move_rejection(Board &board, const LegalityMasks &masks, Move &move);
+
+/**
+ * All legal moves of the given side, castling and every promotion piece included
+ */
+template<Color Us>
+void generate_legal_moves(Board &board, MoveList &moves);
+void generate_legal_moves(Board &board, bool white, MoveList &moves);
+std::vector<Move> generate_legal_moves(Board &board, bool white);
+
+/**
+ * Only the legal moves that give check. Tests the target squares against precomputed check squares
+ * and discovered check lines instead of playing every move; castling, en passant and promotions are played.
+ */
+template<Color Us>
+void generate_checking_moves(Board &board, MoveList &moves);
+std::vector<Move> generate_checking_moves(Board &board, bool white);
+
+template<Color Us>
+GameState get_game_state(Board &board);
+GameState get_game_state(Board &board, bool white);
+
+#endif //CHESS_TUI_MOVE_GENERATOR_HPP
@@ -0,0 +1,71 @@
+#ifndef CHESS_TUI_NNUE_HPP
+#define CHESS_TUI_NNUE_HPP
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "chess-tui/board.hpp"
+
+/*
+ * Efficiently updatable neural network evaluation with HalfKP features: for each perspective
+ * (king square, non-king piece, square), 64 * 10 * 64 inputs into NNUE_L1 neurons, followed by a
+ * clipped ReLU and a single output neuron over both perspectives (side to move first).
+ */
+inline constexpr int NNUE_L1 = 256;
+inline constexpr int NNUE_FEATURES = 64 * 10 * 64;
+inline constexpr int NNUE_CLIP = 127;
+
+/**
+ * First layer outputs of both perspectives, indexed [white] like Board::kings
+ */
+struct alignas(32) NnueAccumulator
+{
+    std::array<std::array<int16_t, NNUE_L1>, 2> values;
+    // Square of each king the features were computed for, y * 8 + x
+    std::array<uint8_t, 2> king_squares;
+};
+
+/**
+ * Read-only network weights, mapped straight from the file (see README for the layout).
+ */
+class NnueNetwork
+{
+public:
+    /**
+     * Throws std::runtime_error if the file cannot be mapped or does not match the expected layout
+     */
+    explicit NnueNetwork(const std::string &path);
+    ~NnueNetwork();
+
+    NnueNetwork(const NnueNetwork &) = delete;
+    NnueNetwork &operator=(const NnueNetwork &) = delete;
+
+    /**
+     * Computes both perspectives from scratch
+     */
+    void refresh(Board &board, NnueAccumulator &accumulator) const;
+
+    /**
+     * Derives the accumulator after the last move on board from the one before it,
+     * adding and subtracting the weight columns of the pieces that moved
+     */
+    void update(Board &board, const NnueAccumulator &before, NnueAccumulator &after) const;
+
+    /**
+     * Centipawns from the point of view of the side to move
+     */
+    [[nodiscard]] int evaluate(const Board &board, const NnueAccumulator &accumulator) const;
+
+private:
+    void refreshPerspective(Board &board, NnueAccumulator &accumulator, bool perspective) const;
+
+    void *mapping = nullptr;
+    size_t mapping_size = 0;
+    int32_t scale = 1;
+    int32_t output_bias = 0;
+    const int16_t *feature_biases = nullptr;
+    const int16_t *output_weights = nullptr;
+    const int16_t *feature_weights = nullptr;
+};
+
+#endif //CHESS_TUI_NNUE_HPP
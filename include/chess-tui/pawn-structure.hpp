@@ -0,0 +1,75 @@
+#ifndef CHESS_TUI_PAWN_STRUCTURE_HPP
+#define CHESS_TUI_PAWN_STRUCTURE_HPP
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "chess-tui/square-set.hpp"
+
+/**
+ * Number of pawns per pawn structure term, indexed [white]. Every term is linear in its count,
+ * the weights live in eval-params.hpp.
+ */
+struct PawnFeatures
+{
+    // Pawns on a file beyond the first
+    std::array<int, 2> doubled{};
+    // Pawns without own pawns on the neighbouring files
+    std::array<int, 2> isolated{};
+    // Pawns without enemy pawns in front of them on their own and the neighbouring files, by relative rank
+    std::array<std::array<int, 8>, 2> passed{};
+    // Own pawns on the three files around the king, one or two ranks in front of it
+    std::array<int, 2> shield{};
+};
+
+PawnFeatures count_pawn_features(const std::array<SquareSet, 2> &pawns, const std::array<BoardPos, 2> &kings);
+
+/**
+ * Pawn structure score from white's point of view
+ */
+int pawn_structure_score(const PawnFeatures &features);
+
+struct PawnCacheStats
+{
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+};
+
+/**
+ * Direct-mapped cache of pawn structure scores keyed by Board::pawn_hash. Meant to be used
+ * by one thread only, so neither lookups nor the statistics need synchronization.
+ */
+class PawnCache
+{
+public:
+    explicit PawnCache(size_t entries = 1 << 13);
+    ~PawnCache();
+
+    bool probe(uint64_t key, int &score);
+    void store(uint64_t key, int score);
+
+    [[nodiscard]] const PawnCacheStats &getStats() const;
+
+    /**
+     * The cache of the calling thread
+     */
+    static PawnCache &local();
+
+    /**
+     * Sum over all threads that have finished plus the calling thread
+     */
+    static PawnCacheStats totalStats();
+
+private:
+    struct Entry
+    {
+        uint64_t key = 0;
+        int32_t score = 0;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t mask;
+    PawnCacheStats stats;
+};
+
+#endif //CHESS_TUI_PAWN_STRUCTURE_HPP
@@ -7,16 +7,17 @@
 
 #include "board.hpp"
 #include "chess-tui/piece.hpp"
+#include "chess-tui/square-set.hpp"
 
 class reachable_cells_visitor;
 
 bool is_reachable(Board &board, const BoardPos &pos, bool white);
-void remove_enemy_reachable_cells(Board &board, bool white, std::set<BoardPos> &cells);
+void remove_enemy_reachable_cells(Board &board, bool white, SquareSet &cells);
 
 class reachable_cells_visitor final : public PieceVisitor
 {
 public:
-    std::set<BoardPos> reachable_cells;
+    SquareSet reachable_cells;
 
     explicit reachable_cells_visitor(Board &board, const BoardPos &pos, bool current_player_white);
 
@@ -40,6 +41,9 @@ public:
     ReachableResult check_reachable(const Piece &piece, const BoardPos &dest, bool can_walk, bool can_capture);
 
 private:
+    template<Color Us>
+    void visitPawn(Pawn &pawn);
+
     Board &board;
     BoardPos pos;
     bool current_player_white;
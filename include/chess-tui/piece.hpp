@@ -4,6 +4,7 @@
 
 #ifndef CHESS_TUI_PIECE_HPP
 #define CHESS_TUI_PIECE_HPP
+#include <memory>
 #include <string>
 
 #include "chess-tui/vector.hpp"
@@ -46,9 +47,6 @@ struct Pawn final : Piece {
   explicit Pawn(const bool white) : Piece(white) {}
   Pawn(const bool white, const bool has_moved) : Piece(white, has_moved) {}
 
-  const int8_t dir = white ? 1 : -1;
-  const uint8_t start_rank = white ? 1 : 6;
-
   std::string getUnicode() override;
 
   void visit(PieceVisitor &pieceVisitor) override;
@@ -111,4 +109,9 @@ struct Queen final : Piece {
   char getSymbol() override;
 };
 
+/**
+ * Creates a piece from its symbol (P, R, B, N, K, Q), throws std::invalid_argument for anything else
+ */
+std::shared_ptr<Piece> createPiece(char symbol, bool white, bool has_moved = false);
+
 #endif //CHESS_TUI_PIECE_HPP
\ No newline at end of file
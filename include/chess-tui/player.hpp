@@ -7,6 +7,9 @@
 #include <random>
 
 #include "board.hpp"
+#include "chess-tui/clock.hpp"
+#include "chess-tui/search.hpp"
+#include "chess-tui/transposition-table.hpp"
 
 class Player
 {
@@ -17,10 +20,15 @@ public:
 };
 
 /**
- * Currently only supports format (a2b3)
+ * Currently only supports format (a2b3), with an optional promotion piece (a7a8q)
  */
 Move convertMove(const std::string &input);
 
+/**
+ * Inverse of convertMove for castling and normal moves (O-O, O-O-O, a2b3, a7a8q)
+ */
+std::string formatMove(const Move &move);
+
 
 class LocalPlayer final : public Player
 {
@@ -37,4 +45,26 @@ public:
     Move requestMove() override;
 };
 
+/**
+ * Plays the best move of a fixed depth search for whichever side is to move on the board
+ */
+class SearchBotPlayer final : public Player {
+    Board &board;
+    TranspositionTable &tt;
+    SearchLimits limits;
+    const NnueNetwork *network;
+    const GameClock *clock;
+public:
+    /**
+     * With a clock the search time is derived from the bot's remaining time instead of limits.depth
+     */
+    SearchBotPlayer(Board &board, TranspositionTable &tt, const SearchLimits &limits,
+                    const NnueNetwork *network = nullptr, const GameClock *clock = nullptr);
+
+    /**
+     * Only for positions with a legal move, throws std::logic_error after checkmate or stalemate
+     */
+    Move requestMove() override;
+};
+
 #endif //CHESS_TUI_PLAYER_HPP
\ No newline at end of file
@@ -0,0 +1,138 @@
+#ifndef CHESS_TUI_SEARCH_HPP
+#define CHESS_TUI_SEARCH_HPP
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "chess-tui/board.hpp"
+#include "chess-tui/move-generator.hpp"
+#include "chess-tui/nnue.hpp"
+#include "chess-tui/transposition-table.hpp"
+
+inline constexpr int MAX_PLY = 64;
+inline constexpr int MATE_SCORE = 32000;
+inline constexpr int INFINITE_SCORE = 32001;
+
+inline bool is_mate_score(const int score) {
+    return score > MATE_SCORE - MAX_PLY || score < -MATE_SCORE + MAX_PLY;
+}
+
+/**
+ * Selective search techniques, each can be switched off on its own to measure what it is worth
+ */
+struct Selectivity
+{
+    // Let the opponent move twice at reduced depth, a fail high still proves the node is good enough.
+    // Never with only king and pawns, where passing could be better than every move (zugzwang).
+    bool null_move = true;
+    // Search late quiet moves, ordered by the history table, shallower and re-search them if they surprise
+    bool late_move_reductions = true;
+    // Skip quiet moves one or two plies above the horizon when even a margin on the static eval stays below alpha
+    bool futility = true;
+    // Search one ply deeper when the side to move is in check
+    bool check_extensions = true;
+
+    static constexpr Selectivity none() { return {false, false, false, false}; }
+};
+
+struct SearchLimits
+{
+    int depth = 5;
+    // Number of best root moves to report, each with its own exact score and line
+    int multi_pv = 1;
+    // Time limits, zero for none. No new iteration is started after the soft limit (scaled by how
+    // stable the best move is), the search is aborted at the hard limit.
+    std::chrono::milliseconds soft_time{0};
+    std::chrono::milliseconds hard_time{0};
+    Selectivity selectivity{};
+};
+
+struct PvLine
+{
+    int score = 0;
+    std::vector<Move> moves;
+};
+
+struct SearchResult
+{
+    // Best line first. Without legal moves a single line with the final score and no moves
+    std::vector<PvLine> lines;
+    int depth = 0;
+    uint64_t nodes = 0;
+};
+
+/**
+ * Iterative deepening alpha-beta search on a board owned by the caller.
+ * One Searcher per thread, the transposition table may be shared between threads.
+ */
+class Searcher
+{
+public:
+    /**
+     * Evaluates with network if given, otherwise with the handcrafted evaluation
+     */
+    Searcher(Board &board, TranspositionTable &tt, const NnueNetwork *network = nullptr);
+
+    SearchResult search(const SearchLimits &limits);
+
+private:
+    template<Color Us>
+    SearchResult searchRoot(const SearchLimits &limits);
+
+    template<Color Us>
+    int negamax(int depth, int ply, int alpha, int beta, bool null_allowed = true);
+
+    template<Color Us>
+    int quiescence(int ply, int alpha, int beta);
+
+    /**
+     * Plays move at ply and brings the accumulator of ply + 1 up to date
+     */
+    template<Color Us>
+    void makeMove(const Move &move, int ply);
+
+    int evaluatePosition(int ply);
+
+    /**
+     * Whether the hard time limit has passed, only looks at the clock every few thousand nodes
+     */
+    bool timeUp();
+
+    /**
+     * Hash move first, then captures and promotions by most valuable victim / least valuable attacker,
+     * then quiet moves by history
+     */
+    template<Color Us>
+    void orderMoves(MoveList &moves, const Move &tt_move);
+
+    /**
+     * Rewards a quiet move that caused a beta cutoff, by depth squared
+     */
+    template<Color Us>
+    void updateHistory(const Move &move, int depth);
+
+    void updatePv(int ply, const Move &move);
+
+    Board &board;
+    TranspositionTable &tt;
+    const NnueNetwork *network;
+    // Per-ply buffers on the thread's scratch arena, only valid during a search:
+    // the accumulator of the position at each ply, copied forward and updated on every move,
+    // and the moves of the node at each ply, reused by all nodes at that ply
+    NnueAccumulator *accumulators = nullptr;
+    MoveList *move_lists = nullptr;
+    uint64_t nodes = 0;
+    Selectivity selectivity;
+    // Cutoffs caused by a quiet move, per side to move, from square and to square
+    std::array<std::array<std::array<int, 64>, 64>, 2> history{};
+    std::chrono::steady_clock::time_point hard_deadline;
+    bool timed = false;
+    // Set once the hard limit is hit, everything searched after that is discarded
+    bool stopped = false;
+    // Triangular PV table, the line found at ply starts at pv[ply][ply]
+    std::array<std::array<Move, MAX_PLY>, MAX_PLY> pv{};
+    std::array<int, MAX_PLY> pv_length{};
+};
+
+#endif //CHESS_TUI_SEARCH_HPP
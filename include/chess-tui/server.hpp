@@ -0,0 +1,32 @@
+#ifndef CHESS_TUI_SERVER_HPP
+#define CHESS_TUI_SERVER_HPP
+#include <string>
+
+#include "chess-tui/nnue.hpp"
+
+struct ServerOptions
+{
+    // Search depth of the bot
+    int depth = 4;
+    // Bot workers, 0 uses one per hardware thread
+    unsigned threads = 0;
+    size_t hash_megabytes = 64;
+    // Evaluation of the bot, handcrafted if not set
+    const NnueNetwork *network = nullptr;
+};
+
+/**
+ * Hosts any number of games on a Unix domain socket, one game session per connection.
+ * A single epoll loop handles all connections, bot moves are searched on a shared worker pool.
+ *
+ * Line protocol, one command per line:
+ *   new white|black|both   start a game, playing white or black against the bot, or both sides
+ *   <move>                 a move in the format of convertMove (e2e4, O-O, e7e8q)
+ *   moves                  list the legal moves
+ *   board                  the position as 64 symbols from a1 to h8, '.' for empty squares
+ *   quit                   close the connection
+ * Replies: "ok <move>", "move <move>" (bot), "moves ...", "board ...", "end <result> <reason>", "err <reason>"
+ */
+int runServer(const std::string &socket_path, const ServerOptions &options);
+
+#endif //CHESS_TUI_SERVER_HPP
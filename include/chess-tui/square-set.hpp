@@ -0,0 +1,103 @@
+#ifndef CHESS_TUI_SQUARE_SET_HPP
+#define CHESS_TUI_SQUARE_SET_HPP
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+
+#include "chess-tui/vector.hpp"
+
+inline uint8_t square_index(const BoardPos &pos) {
+    return static_cast<uint8_t>(pos.y * 8 + pos.x);
+}
+
+inline BoardPos square_pos(const int index) {
+    return {static_cast<int8_t>(index % 8), static_cast<int8_t>(index / 8)};
+}
+
+/**
+ * Set of squares as a bitmap, bit y * 8 + x. A value type: copying, merging and lookups are single
+ * instructions and never allocate. Iterates from a1 to h8 by lowest set bit.
+ */
+struct SquareSet
+{
+    uint64_t bits = 0;
+
+    class iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = BoardPos;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = BoardPos;
+
+        iterator() = default;
+        explicit iterator(const uint64_t remaining) : remaining(remaining) {}
+
+        BoardPos operator*() const { return square_pos(std::countr_zero(remaining)); }
+        iterator &operator++() {
+            remaining &= remaining - 1;
+            return *this;
+        }
+        iterator operator++(int) {
+            const iterator before = *this;
+            ++*this;
+            return before;
+        }
+        bool operator==(const iterator &other) const = default;
+
+    private:
+        uint64_t remaining = 0;
+    };
+
+    constexpr SquareSet() = default;
+    constexpr explicit SquareSet(const uint64_t bits) : bits(bits) {}
+    explicit SquareSet(const BoardPos &pos) : bits(uint64_t{1} << square_index(pos)) {}
+    SquareSet(const std::initializer_list<BoardPos> squares) {
+        for (const BoardPos &pos : squares) {
+            this->insert(pos);
+        }
+    }
+
+    static constexpr SquareSet all() { return SquareSet(~uint64_t{0}); }
+
+    [[nodiscard]] bool contains(const BoardPos &pos) const { return bits >> square_index(pos) & 1; }
+    [[nodiscard]] bool contains(const SquareSet &other) const { return (bits & other.bits) == other.bits; }
+    [[nodiscard]] int size() const { return std::popcount(bits); }
+    [[nodiscard]] bool empty() const { return bits == 0; }
+    // More than one square, without counting
+    [[nodiscard]] bool several() const { return (bits & (bits - 1)) != 0; }
+    explicit operator bool() const { return bits != 0; }
+
+    void insert(const BoardPos &pos) { bits |= uint64_t{1} << square_index(pos); }
+    void erase(const BoardPos &pos) { bits &= ~(uint64_t{1} << square_index(pos)); }
+    void erase(const SquareSet &other) { bits &= ~other.bits; }
+
+    [[nodiscard]] BoardPos front() const { return square_pos(std::countr_zero(bits)); }
+    [[nodiscard]] iterator begin() const { return iterator(bits); }
+    [[nodiscard]] iterator end() const { return iterator(0); }
+
+    SquareSet operator|(const SquareSet &other) const { return SquareSet(bits | other.bits); }
+    SquareSet operator&(const SquareSet &other) const { return SquareSet(bits & other.bits); }
+    SquareSet operator^(const SquareSet &other) const { return SquareSet(bits ^ other.bits); }
+    // Difference
+    SquareSet operator-(const SquareSet &other) const { return SquareSet(bits & ~other.bits); }
+    SquareSet operator~() const { return SquareSet(~bits); }
+    SquareSet &operator|=(const SquareSet &other) {
+        bits |= other.bits;
+        return *this;
+    }
+    SquareSet &operator&=(const SquareSet &other) {
+        bits &= other.bits;
+        return *this;
+    }
+    SquareSet &operator-=(const SquareSet &other) {
+        bits &= ~other.bits;
+        return *this;
+    }
+    bool operator==(const SquareSet &other) const = default;
+};
+
+#endif //CHESS_TUI_SQUARE_SET_HPP
@@ -0,0 +1,57 @@
+#ifndef CHESS_TUI_TRANSPOSITION_TABLE_HPP
+#define CHESS_TUI_TRANSPOSITION_TABLE_HPP
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "chess-tui/board.hpp"
+
+enum class Bound : uint8_t {
+    NONE = 0,
+    UPPER = 1,
+    LOWER = 2,
+    EXACT = 3,
+};
+
+struct TTEntry
+{
+    Move move;
+    int score = 0;
+    int depth = 0;
+    Bound bound = Bound::NONE;
+};
+
+/**
+ * Packs a move into 16 bits: from square in bits 0-5, to square in bits 6-11 and the kind in bits 12-14
+ * (0 no move, 1 normal, 2 castling with the side in the low bits, 3-6 promotion to N, B, R, Q).
+ */
+uint16_t encode_move(const Move &move);
+Move decode_move(uint16_t encoded);
+
+/**
+ * Hash table shared by all search threads. Slots are written without locks, a torn write
+ * is detected by storing the key xor'ed with the data, so a reader never sees a mix of two entries.
+ */
+class TranspositionTable
+{
+public:
+    explicit TranspositionTable(size_t megabytes);
+
+    bool probe(uint64_t key, TTEntry &entry) const;
+
+    void store(uint64_t key, const Move &move, int score, int depth, Bound bound);
+
+    void clear();
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> checked_key{0};
+        std::atomic<uint64_t> data{0};
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+};
+
+#endif //CHESS_TUI_TRANSPOSITION_TABLE_HPP
@@ -0,0 +1,69 @@
+#ifndef CHESS_TUI_TUNER_HPP
+#define CHESS_TUI_TUNER_HPP
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * A labeled training position, 40 bytes. Pieces are stored as one nibble each (white << 3 | piece_type_index)
+ * in the order of the set bits of occupancy (bit y * 8 + x).
+ */
+struct TunePosition
+{
+    uint64_t occupancy = 0;
+    std::array<uint8_t, 16> pieces{};
+    // Game result from white's point of view: 0 loss, 1 draw, 2 win
+    uint8_t result = 1;
+    // White minus black count of each pawn structure term (doubled, isolated, passed by rank, shield),
+    // computed once while parsing as they do not depend on the parameters
+    std::array<int8_t, 11> pawn_terms{};
+};
+
+/*
+ * The tuned parameters as one flat vector: piece_values, the six piece square tables, then doubled_pawn,
+ * isolated_pawn, passed_pawn and pawn_shield, in the layout of eval-params.hpp
+ */
+inline constexpr int TUNE_PARAM_COUNT = 6 + 6 * 64 + 11;
+using TuneParams = std::array<double, TUNE_PARAM_COUNT>;
+
+struct TuneOptions
+{
+    int epochs = 500;
+    // Adam step size in centipawns
+    double learning_rate = 1.0;
+    // 0 uses one worker per hardware thread
+    unsigned threads = 0;
+};
+
+/**
+ * Parses "<FEN> <result>" where only the piece placement of the FEN is used. The result may be written as
+ * 1-0 / 0-1 / 1/2-1/2 or 1.0 / 0.0 / 0.5, optionally quoted or in brackets.
+ * Throws std::invalid_argument on malformed lines.
+ */
+TunePosition parse_labeled_position(const std::string &line);
+
+/**
+ * Reads one labeled position per line, empty lines are skipped
+ */
+std::vector<TunePosition> read_labeled_positions(std::istream &in);
+
+/**
+ * The current evaluation weights from eval-params.hpp
+ */
+TuneParams default_tune_params();
+
+/**
+ * Minimizes the mean squared error between game results and sigmoid(K * evaluation), first fitting K to the
+ * starting parameters, then running full batch Adam. Gradients are accumulated per worker and summed afterwards.
+ */
+TuneParams tune(const std::vector<TunePosition> &positions, const TuneParams &start, const TuneOptions &options,
+                std::ostream &log);
+
+/**
+ * Writes params as eval-params.hpp
+ */
+void write_eval_params(const TuneParams &params, std::ostream &out);
+
+#endif //CHESS_TUI_TUNER_HPP
@@ -4,10 +4,11 @@
 
 #ifndef CHESS_TUI_VECTOR_HPP
 #define CHESS_TUI_VECTOR_HPP
+#include <array>
 #include <cstdint>
-#include <set>
 #include <vector>
 
+struct VectorList;
 
 struct Vector {
   int8_t x, y;
@@ -30,13 +31,27 @@ struct Vector {
 
   [[nodiscard]] Vector rotate90(bool clockwise) const;
 
-  [[nodiscard]] std::set<Vector> getAllPossibleTransforms() const;
+  [[nodiscard]] VectorList getAllPossibleTransforms() const;
 
   [[nodiscard]] bool isWithinGrid() const;
 
   bool operator<(const Vector &other) const;
 };
 
+/**
+ * Up to 8 distinct vectors, stored inline
+ */
+struct VectorList {
+  std::array<Vector, 8> vectors;
+  uint8_t count = 0;
+
+  // Ignores vectors already contained
+  void insert(const Vector &vector);
+
+  [[nodiscard]] const Vector *begin() const { return vectors.data(); }
+  [[nodiscard]] const Vector *end() const { return vectors.data() + count; }
+};
+
 typedef Vector BoardPos;
 
 #endif //CHESS_TUI_VECTOR_HPP
\ No newline at end of file
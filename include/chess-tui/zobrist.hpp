@@ -0,0 +1,66 @@
+#ifndef CHESS_TUI_ZOBRIST_HPP
+#define CHESS_TUI_ZOBRIST_HPP
+#include <array>
+#include <cstdint>
+
+#include "chess-tui/vector.hpp"
+
+struct ZobristKeys
+{
+    // [white * 6 + piece type][y * 8 + x]
+    std::array<std::array<uint64_t, 64>, 12> pieces;
+    uint64_t black_to_move;
+    // Same order as Board::initial_rooks: castling with that rook is still possible
+    std::array<uint64_t, 4> castling;
+    std::array<uint64_t, 8> en_passant_file;
+};
+
+/*
+ * Keys are derived from a fixed seed, so hashes are stable between runs and can be stored on disk.
+ */
+constexpr ZobristKeys generate_zobrist_keys() {
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    auto next = [&state] {
+        // splitmix64
+        uint64_t z = state += 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    };
+    ZobristKeys keys{};
+    for (auto &piece : keys.pieces) {
+        for (auto &key : piece) {
+            key = next();
+        }
+    }
+    keys.black_to_move = next();
+    for (auto &key : keys.castling) {
+        key = next();
+    }
+    for (auto &key : keys.en_passant_file) {
+        key = next();
+    }
+    return keys;
+}
+
+inline constexpr ZobristKeys zobrist_keys = generate_zobrist_keys();
+
+/**
+ * Maps a piece symbol (P, N, B, R, Q, K) to 0..5
+ */
+constexpr uint8_t piece_type_index(const char symbol) {
+    switch (symbol) {
+        case 'P': return 0;
+        case 'N': return 1;
+        case 'B': return 2;
+        case 'R': return 3;
+        case 'Q': return 4;
+        default: return 5;
+    }
+}
+
+inline uint64_t zobrist_piece_key(const bool white, const char symbol, const BoardPos &pos) {
+    return zobrist_keys.pieces[white * 6 + piece_type_index(symbol)][pos.y * 8 + pos.x];
+}
+
+#endif //CHESS_TUI_ZOBRIST_HPP
@@ -0,0 +1,138 @@
+#include "chess-tui/analysis.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#include "chess-tui/arena.hpp"
+#include "chess-tui/move-generator.hpp"
+#include "chess-tui/player.hpp"
+#include "chess-tui/search.hpp"
+
+namespace {
+    std::string format_score(const int score) {
+        if (is_mate_score(score)) {
+            const int moves = (MATE_SCORE - std::abs(score) + 1) / 2;
+            if (moves == 0) return "#";
+            return (score > 0 ? "#" : "-#") + std::to_string(moves);
+        }
+        std::ostringstream out;
+        out << std::showpos << std::fixed << std::setprecision(2) << score / 100.0;
+        return out.str();
+    }
+
+    std::string format_line(const std::vector<Move> &moves) {
+        std::string line;
+        for (const Move &move : moves) {
+            if (!line.empty()) line += ' ';
+            line += formatMove(move);
+        }
+        return line;
+    }
+
+    /*
+     * Played move loss in centipawns -> annotation
+     */
+    const char *annotation(const int loss) {
+        if (loss >= 300) return "??";
+        if (loss >= 100) return "?";
+        if (loss >= 50) return "?!";
+        return "";
+    }
+}
+
+void writeGameRecord(const Board &board, std::ostream &out) {
+    for (const UndoInfo &undo : board.history) {
+        out << formatMove(undo.move) << std::endl;
+    }
+}
+
+std::vector<Move> readGameRecord(std::istream &in) {
+    std::vector<Move> moves;
+    std::string input;
+    while (in >> input) {
+        moves.push_back(convertMove(input));
+    }
+    return moves;
+}
+
+void analyzeGame(const std::vector<Move> &moves, const AnalysisOptions &options, std::ostream &out) {
+    // Validate the whole record up front, so workers can replay it blindly
+    Board replay;
+    ScratchScope scratch;
+    MoveList legal_moves(scratch.resource());
+    legal_moves.reserve(MAX_MOVES);
+    for (const Move &move : moves) {
+        legal_moves.clear();
+        generate_legal_moves(replay, replay.white_to_move, legal_moves);
+        if (move.isCommand() || std::ranges::find(legal_moves, move) == legal_moves.end()) {
+            throw std::invalid_argument("illegal move in game record: " + formatMove(move));
+        }
+        replay.makeMove(move);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    TranspositionTable tt(options.hash_megabytes);
+    std::vector<SearchResult> results(moves.size() + 1);
+    std::atomic<size_t> next_position = 0;
+    auto worker = [&] {
+        // A worker claims increasing positions, so one board per worker is played forward to each of them
+        Board board;
+        size_t played = 0;
+        for (size_t index; (index = next_position.fetch_add(1)) < results.size();) {
+            for (; played < index; ++played) {
+                board.makeMove(moves[played]);
+            }
+            Searcher searcher(board, tt, options.network);
+            results[index] = searcher.search({.depth = options.depth, .multi_pv = options.multi_pv});
+        }
+    };
+    const unsigned thread_count = options.threads ? options.threads : std::max(std::thread::hardware_concurrency(), 1u);
+    {
+        std::vector<std::jthread> pool;
+        for (unsigned i = 0; i < std::min<size_t>(thread_count, results.size()); ++i) {
+            pool.emplace_back(worker);
+        }
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    std::array<std::array<int, 3>, 2> mistakes{};
+    uint64_t nodes = 0;
+    for (size_t i = 0; i < moves.size(); ++i) {
+        const bool white = i % 2 == 0;
+        const SearchResult &before = results[i];
+        const int best_score = before.lines.front().score;
+        // The position after the move is scored from the opponent's point of view
+        const bool played_best = before.lines.front().moves.front() == moves[i];
+        const int played_score = played_best ? best_score : -results[i + 1].lines.front().score;
+        const char *flag = annotation(best_score - played_score);
+        if (*flag) {
+            ++mistakes[!white][std::string_view(flag) == "??" ? 2 : std::string_view(flag) == "?" ? 1 : 0];
+        }
+
+        out << std::setw(3) << i / 2 + 1 << (white ? ".  " : "... ") << std::left << std::setw(7)
+                << formatMove(moves[i]) + flag << std::right << std::setw(7)
+                << format_score(white ? played_score : -played_score);
+        if (!played_best) {
+            out << "  best " << formatMove(before.lines.front().moves.front());
+        }
+        out << std::endl;
+        for (const PvLine &line : before.lines) {
+            out << "        " << std::setw(7) << format_score(white ? line.score : -line.score) << "  "
+                    << format_line(line.moves) << std::endl;
+        }
+        nodes += before.nodes;
+    }
+    nodes += results.back().nodes;
+
+    for (const bool white : {true, false}) {
+        const auto &counts = mistakes[!white];
+        out << (white ? "White" : "Black") << ": " << counts[0] << " inaccuracies, " << counts[1] << " mistakes, "
+                << counts[2] << " blunders" << std::endl;
+    }
+    out << results.size() << " positions, depth " << options.depth << ", " << nodes << " nodes in "
+            << elapsed.count() << " ms on " << thread_count << " threads" << std::endl;
+}
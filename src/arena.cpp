@@ -0,0 +1,81 @@
+#include "chess-tui/arena.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+namespace {
+    struct ThreadArena
+    {
+        std::unique_ptr<std::byte[]> block = std::make_unique_for_overwrite<std::byte[]>(ScratchScope::block_size);
+        std::pmr::monotonic_buffer_resource resource{block.get(), ScratchScope::block_size,
+                                                     std::pmr::new_delete_resource()};
+        int open_scopes = 0;
+    };
+
+    // Created on the first scope of each thread, so threads that never search cost nothing
+    thread_local ThreadArena thread_arena;
+
+    std::atomic<uint64_t> allocation_count = 0;
+}
+
+ScratchScope::ScratchScope() {
+    ++thread_arena.open_scopes;
+}
+
+ScratchScope::~ScratchScope() {
+    if (--thread_arena.open_scopes == 0) {
+        thread_arena.resource.release();
+    }
+}
+
+std::pmr::memory_resource *ScratchScope::resource() const {
+    return &thread_arena.resource;
+}
+
+uint64_t global_allocation_count() {
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+#ifdef CHESS_TUI_COUNT_ALLOCATIONS
+/*
+ * Replacements of the global allocation functions that count every call. The array and nothrow forms
+ * forward to these by default.
+ */
+void *operator new(const std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void *pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(const std::size_t size, const std::align_val_t alignment) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    const auto align = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants a multiple of the alignment
+    const std::size_t rounded = std::max((size + align - 1) / align * align, align);
+    if (void *pointer = std::aligned_alloc(align, rounded)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+#endif
@@ -0,0 +1,73 @@
+#include "chess-tui/batch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+#include "chess-tui/search.hpp"
+#include "chess-tui/transposition-table.hpp"
+
+namespace {
+    // Legal moves and states take microseconds, so workers claim them in chunks
+    // instead of contending on the counter for every position. Searches are claimed one by one.
+    constexpr size_t cheap_chunk_size = 64;
+
+    void answer(Board &board, const BatchOptions &options, TranspositionTable *tt, BatchResult &result) {
+        const bool white = board.white_to_move;
+        result.state = get_game_state(board, white);
+        switch (options.query) {
+            case BatchQuery::LEGAL_MOVES:
+                result.legal_moves = generate_legal_moves(board, white);
+                break;
+            case BatchQuery::GAME_STATE:
+                break;
+            case BatchQuery::BEST_MOVE: {
+                Searcher searcher(board, *tt, options.network);
+                const SearchResult search = searcher.search({.depth = options.depth});
+                const PvLine &best = search.lines.front();
+                result.score = best.score;
+                if (!best.moves.empty()) {
+                    result.best_move = best.moves.front();
+                }
+                break;
+            }
+        }
+    }
+}
+
+std::vector<BatchResult> query_positions(std::vector<Board> &positions, const BatchOptions &options) {
+    std::vector<BatchResult> results(positions.size());
+    std::optional<TranspositionTable> tt;
+    if (options.query == BatchQuery::BEST_MOVE) {
+        tt.emplace(options.hash_megabytes);
+    }
+    const size_t chunk_size = options.query == BatchQuery::BEST_MOVE ? 1 : cheap_chunk_size;
+    std::atomic<size_t> next_position = 0;
+    auto worker = [&] {
+        for (size_t begin; (begin = next_position.fetch_add(chunk_size)) < positions.size();) {
+            const size_t end = std::min(begin + chunk_size, positions.size());
+            for (size_t i = begin; i < end; ++i) {
+                answer(positions[i], options, tt ? &*tt : nullptr, results[i]);
+            }
+        }
+    };
+    const unsigned thread_count = options.threads ? options.threads : std::max(std::thread::hardware_concurrency(), 1u);
+    const size_t chunk_count = (positions.size() + chunk_size - 1) / chunk_size;
+    {
+        std::vector<std::jthread> pool;
+        for (unsigned i = 0; i < std::min<size_t>(thread_count, chunk_count); ++i) {
+            pool.emplace_back(worker);
+        }
+    }
+    return results;
+}
+
+std::vector<BatchResult> query_positions(const std::vector<std::string> &fens, const BatchOptions &options) {
+    std::vector<Board> positions(fens.size());
+    for (size_t i = 0; i < fens.size(); ++i) {
+        positions[i].readFen(fens[i]);
+    }
+    return query_positions(positions, options);
+}
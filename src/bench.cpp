@@ -0,0 +1,128 @@
+#include "chess-tui/bench.hpp"
+
+#include <array>
+#include <iomanip>
+#include <string>
+
+#include "chess-tui/arena.hpp"
+#include "chess-tui/board.hpp"
+#include "chess-tui/move-generator.hpp"
+#include "chess-tui/transposition-table.hpp"
+
+namespace {
+    const std::array<const char *, 8> bench_positions = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+        "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+        "2r3k1/pp3ppp/2n1b3/3p4/3P4/2NB1N2/PP3PPP/2R3K1 w - - 0 20",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "8/8/1p1k4/p2p4/P2P4/1P1K4/8/8 w - - 0 1",
+    };
+
+    struct BenchConfig
+    {
+        const char *name;
+        Selectivity selectivity;
+    };
+
+    const std::array<BenchConfig, 6> bench_configs = {{
+        {"none", Selectivity::none()},
+        {"null move", {true, false, false, false}},
+        {"late move reductions", {false, true, false, false}},
+        {"futility", {false, false, true, false}},
+        {"check extensions", {false, false, false, true}},
+        {"all", Selectivity{}},
+    }};
+
+    /*
+     * Plays one game, returns 1 if white wins, 0 for a draw, -1 if black wins
+     */
+    int play_game(const char *fen, const std::array<SearchLimits, 2> &limits, const MatchOptions &options,
+                  std::array<TranspositionTable, 2> &tables) {
+        Board board;
+        board.readFen(fen);
+        for (TranspositionTable &tt : tables) {
+            tt.clear();
+        }
+        // One searcher per side for the whole game, so each keeps its own history table
+        std::array<Searcher, 2> searchers = {Searcher(board, tables[0], options.network),
+                                             Searcher(board, tables[1], options.network)};
+        for (int ply = 0; ply < 300; ++ply) {
+            const bool white = board.white_to_move;
+            const GameState state = get_game_state(board, white);
+            if (state == GameState::CHECKMATE) return white ? -1 : 1;
+            if (state == GameState::STALEMATE || board.isFiftyMoveDraw() || board.isRepetition()) return 0;
+            board.makeMove(searchers[white].search(limits[white]).lines.front().moves.front());
+        }
+        return 0;
+    }
+}
+
+void run_benchmark(const BenchOptions &options, std::ostream &out) {
+    TranspositionTable tt(options.hash_megabytes);
+    uint64_t baseline_nodes = 0;
+    out << std::left << std::setw(22) << "selectivity" << std::right << std::setw(12) << "nodes" << std::setw(10)
+            << "ms" << std::setw(10) << "nodes/s" << std::setw(10) << "vs none";
+    if (counting_allocations) {
+        out << std::setw(10) << "allocs";
+    }
+    out << std::endl;
+    for (const BenchConfig &config : bench_configs) {
+        uint64_t nodes = 0;
+        uint64_t allocations = 0;
+        std::chrono::nanoseconds elapsed{0};
+        for (const char *fen : bench_positions) {
+            Board board;
+            board.readFen(fen);
+            tt.clear();
+            Searcher searcher(board, tt, options.network);
+            const SearchLimits limits{.depth = options.depth, .multi_pv = 1, .selectivity = config.selectivity};
+            const uint64_t allocations_before = global_allocation_count();
+            const auto start = std::chrono::steady_clock::now();
+            nodes += searcher.search(limits).nodes;
+            elapsed += std::chrono::steady_clock::now() - start;
+            allocations += global_allocation_count() - allocations_before;
+        }
+        if (baseline_nodes == 0) {
+            baseline_nodes = nodes;
+        }
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        out << std::left << std::setw(22) << config.name << std::right << std::setw(12) << nodes << std::setw(10) << ms
+                << std::setw(10) << static_cast<uint64_t>(seconds > 0 ? static_cast<double>(nodes) / seconds : 0)
+                << std::setw(9) << std::fixed << std::setprecision(1)
+                << 100.0 * static_cast<double>(nodes) / static_cast<double>(baseline_nodes) << "%";
+        if (counting_allocations) {
+            out << std::setw(10) << allocations;
+        }
+        out << std::endl;
+    }
+    out << bench_positions.size() << " positions, depth " << options.depth << std::endl;
+}
+
+MatchScore run_match(const MatchOptions &options, std::ostream &out) {
+    const SearchLimits challenger{.depth = MAX_PLY - 1, .multi_pv = 1, .soft_time = options.move_time,
+                                  .hard_time = options.move_time, .selectivity = options.challenger};
+    SearchLimits baseline = challenger;
+    baseline.selectivity = options.baseline;
+    std::array<TranspositionTable, 2> tables = {TranspositionTable(options.hash_megabytes),
+                                                TranspositionTable(options.hash_megabytes)};
+
+    MatchScore score;
+    for (int game = 0; game < options.games; game += 2) {
+        const char *fen = bench_positions[game / 2 % bench_positions.size()];
+        for (const bool challenger_white : {true, false}) {
+            // Indexed by white
+            const std::array<SearchLimits, 2> limits = challenger_white ? std::array{baseline, challenger}
+                                                                        : std::array{challenger, baseline};
+            const int result = play_game(fen, limits, options, tables) * (challenger_white ? 1 : -1);
+            ++(result > 0 ? score.wins : result < 0 ? score.losses : score.draws);
+            out << "Game " << game + !challenger_white + 1 << " (challenger " << (challenger_white ? "white" : "black")
+                    << "): " << (result > 0 ? "win" : result < 0 ? "loss" : "draw") << "  +" << score.wins << " ="
+                    << score.draws << " -" << score.losses << std::endl;
+        }
+    }
+    return score;
+}
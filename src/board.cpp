@@ -1,5 +1,13 @@
 #include "chess-tui/board.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <utility>
+
+#include "chess-tui/move-generator.hpp"
+#include "chess-tui/zobrist.hpp"
+
 BoardPos parseBoardPos(const std::string &input)
 {
     if (input.size() != 2)
@@ -19,8 +27,8 @@ BoardPos parseBoardPos(const std::string &input)
     return {static_cast<int8_t>(file - 97), static_cast<int8_t>(rank - 48 - 1)};
 }
 
-Move::Move(const BoardPos from, const BoardPos to) : from(from),
-                                                     to(to)  {}
+Move::Move(const BoardPos from, const BoardPos to, const char promotion) : from(from),
+                                                     to(to), promotion(promotion)  {}
 
 Move::Move(const int castling) : castling(castling) {
 }
@@ -64,6 +72,8 @@ Board::Board()
     this->kings[1] = std::make_shared<King>(true);
     this->grid[7][4] = this->kings[0];
     this->grid[0][4] = this->kings[1];
+    this->hash = this->computeHash();
+    this->pawn_hash = this->computePawnHash();
 }
 
 void Board::movePiece(const BoardPos &from, const BoardPos &to)
@@ -71,7 +81,436 @@ void Board::movePiece(const BoardPos &from, const BoardPos &to)
     grid[to.y][to.x] = std::move(grid[from.y][from.x]);
 }
 
-void Board::draw(const std::set<BoardPos> &marked_cells) const
+namespace {
+    uint64_t piece_key(Piece &piece, const BoardPos &pos) {
+        return zobrist_piece_key(piece.white, piece.getSymbol(), pos);
+    }
+
+    bool in_pawn_hash(Piece &piece) {
+        const char symbol = piece.getSymbol();
+        return symbol == 'P' || symbol == 'K';
+    }
+
+    /*
+     * Castling rights are not stored explicitly, they follow from the king and the initial rooks
+     * still standing unmoved on their home squares.
+     */
+    uint64_t castling_key(const Board &board) {
+        uint64_t key = 0;
+        for (uint8_t i = 0; i < 4; ++i) {
+            const bool white = i / 2;
+            const int8_t home_x = i % 2 ? 7 : 0;
+            const int8_t home_y = white ? 0 : 7;
+            const auto &rook = board.initial_rooks[i];
+            if (!board.kings[white]->has_moved && !rook->has_moved && board.grid[home_y][home_x] == rook) {
+                key ^= zobrist_keys.castling[i];
+            }
+        }
+        return key;
+    }
+}
+
+template<Color Us>
+void Board::makeMove(const Move &move)
+{
+    using Traits = ColorTraits<Us>;
+    UndoInfo undo{.move = move, .hash = this->hash, .pawn_hash = this->pawn_hash,
+                  .halfmove_clock = this->halfmove_clock, .en_passant = this->en_passant};
+    this->hash ^= castling_key(*this);
+    if (this->en_passant.isWithinGrid()) {
+        this->hash ^= zobrist_keys.en_passant_file[this->en_passant.x];
+    }
+    this->en_passant = {-1, -1};
+
+    if (move.castling) {
+        const bool short_side = move.castling == 1;
+        King &king = *this->kings[Traits::white];
+        Rook &rook = this->getInitialRook<Us>(short_side);
+        undo.moved_before = king.has_moved;
+        undo.rook_moved_before = rook.has_moved;
+
+        const BoardPos king_from = {Traits::king_from_file, Traits::back_rank};
+        const BoardPos king_to = {Traits::king_to_file[short_side], Traits::back_rank};
+        const BoardPos rook_from = {Traits::rook_from_file[short_side], Traits::back_rank};
+        const BoardPos rook_to = {Traits::rook_to_file[short_side], Traits::back_rank};
+        this->hash ^= piece_key(king, king_from) ^ piece_key(king, king_to);
+        this->hash ^= piece_key(rook, rook_from) ^ piece_key(rook, rook_to);
+        this->pawn_hash ^= piece_key(king, king_from) ^ piece_key(king, king_to);
+        this->movePiece(king_from, king_to);
+        this->movePiece(rook_from, rook_to);
+        king.has_moved = true;
+        rook.has_moved = true;
+        ++this->halfmove_clock;
+    } else {
+        auto &piece = this->getPiece(move.from);
+        const bool pawn = piece->getSymbol() == 'P';
+        undo.moved_before = piece->has_moved;
+        const uint64_t move_key = piece_key(*piece, move.from) ^ piece_key(*piece, move.to);
+        this->hash ^= move_key;
+        if (in_pawn_hash(*piece)) {
+            this->pawn_hash ^= move_key;
+        }
+        if (pawn && move.to == undo.en_passant) {
+            const BoardPos captured_pos = {move.to.x, move.from.y};
+            auto &captured = this->getPiece(captured_pos);
+            this->hash ^= piece_key(*captured, captured_pos);
+            this->pawn_hash ^= piece_key(*captured, captured_pos);
+            undo.captured = std::move(captured);
+            undo.en_passant_capture = true;
+        } else if (auto &target = this->getPiece(move.to)) {
+            this->hash ^= piece_key(*target, move.to);
+            if (in_pawn_hash(*target)) {
+                this->pawn_hash ^= piece_key(*target, move.to);
+            }
+            undo.captured = std::move(target);
+        }
+        if (undo.captured || pawn) {
+            this->halfmove_clock = 0;
+        } else {
+            ++this->halfmove_clock;
+        }
+        this->movePiece(move.from, move.to);
+
+        auto &moved = this->getPiece(move.to);
+        moved->has_moved = true;
+        if (move.promotion) {
+            this->hash ^= piece_key(*moved, move.to) ^ zobrist_piece_key(Traits::white, move.promotion, move.to);
+            this->pawn_hash ^= piece_key(*moved, move.to);
+            undo.promoted_pawn = std::move(moved);
+            moved = this->takePromotionPiece(move.promotion, Traits::white);
+        } else if (pawn && move.to.y - move.from.y == 2 * Traits::pawn_dir) {
+            // Only remember the square if an enemy pawn can capture, otherwise equal positions would hash differently
+            for (const int8_t side : {-1, 1}) {
+                const BoardPos neighbour = {static_cast<int8_t>(move.to.x + side), move.to.y};
+                if (!neighbour.isWithinGrid()) continue;
+                const auto &enemy = this->getPiece(neighbour);
+                if (enemy && enemy->white != Traits::white && enemy->getSymbol() == 'P') {
+                    this->en_passant = {move.to.x, static_cast<int8_t>(move.from.y + Traits::pawn_dir)};
+                    this->hash ^= zobrist_keys.en_passant_file[move.to.x];
+                    break;
+                }
+            }
+        }
+    }
+
+    this->hash ^= castling_key(*this) ^ zobrist_keys.black_to_move;
+    this->white_to_move = !Traits::white;
+    this->history.push_back(std::move(undo));
+}
+
+template<Color Us>
+void Board::unmakeMove()
+{
+    using Traits = ColorTraits<Us>;
+    UndoInfo undo = std::move(this->history.back());
+    this->history.pop_back();
+    this->white_to_move = Traits::white;
+
+    const Move &move = undo.move;
+    if (move.castling) {
+        const bool short_side = move.castling == 1;
+        this->movePiece({Traits::king_to_file[short_side], Traits::back_rank}, {Traits::king_from_file, Traits::back_rank});
+        this->movePiece({Traits::rook_to_file[short_side], Traits::back_rank}, {Traits::rook_from_file[short_side], Traits::back_rank});
+        this->kings[Traits::white]->has_moved = undo.moved_before;
+        this->getInitialRook<Us>(short_side).has_moved = undo.rook_moved_before;
+    } else {
+        if (undo.promoted_pawn) {
+            this->spare_pieces.push_back(std::exchange(this->getPiece(move.to), std::move(undo.promoted_pawn)));
+        }
+        this->movePiece(move.to, move.from);
+        this->getPiece(move.from)->has_moved = undo.moved_before;
+        if (undo.en_passant_capture) {
+            this->setPiece({move.to.x, move.from.y}, std::move(undo.captured));
+        } else {
+            this->setPiece(move.to, std::move(undo.captured));
+        }
+    }
+    this->hash = undo.hash;
+    this->pawn_hash = undo.pawn_hash;
+    this->halfmove_clock = undo.halfmove_clock;
+    this->en_passant = undo.en_passant;
+}
+
+template void Board::makeMove<Color::WHITE>(const Move &move);
+template void Board::makeMove<Color::BLACK>(const Move &move);
+template void Board::unmakeMove<Color::WHITE>();
+template void Board::unmakeMove<Color::BLACK>();
+
+void Board::makeMove(const Move &move)
+{
+    if (this->white_to_move) {
+        this->makeMove<Color::WHITE>(move);
+    } else {
+        this->makeMove<Color::BLACK>(move);
+    }
+}
+
+void Board::unmakeMove()
+{
+    // The side that made the last move is the one not to move now
+    if (this->white_to_move) {
+        this->unmakeMove<Color::BLACK>();
+    } else {
+        this->unmakeMove<Color::WHITE>();
+    }
+}
+
+void Board::makeNullMove()
+{
+    this->history.push_back({.hash = this->hash, .pawn_hash = this->pawn_hash, .halfmove_clock = this->halfmove_clock,
+                             .en_passant = this->en_passant});
+    if (this->en_passant.isWithinGrid()) {
+        this->hash ^= zobrist_keys.en_passant_file[this->en_passant.x];
+    }
+    this->en_passant = {-1, -1};
+    this->hash ^= zobrist_keys.black_to_move;
+    this->white_to_move = !this->white_to_move;
+    this->halfmove_clock = 0;
+}
+
+void Board::unmakeNullMove()
+{
+    const UndoInfo &undo = this->history.back();
+    this->hash = undo.hash;
+    this->en_passant = undo.en_passant;
+    this->halfmove_clock = undo.halfmove_clock;
+    this->white_to_move = !this->white_to_move;
+    this->history.pop_back();
+}
+
+void Board::resetHistory()
+{
+    this->history.clear();
+    this->en_passant = {-1, -1};
+    this->halfmove_clock = 0;
+    this->hash = this->computeHash();
+    this->pawn_hash = this->computePawnHash();
+}
+
+void Board::writePieces(std::ostream &out) const
+{
+    std::vector<BoardPos> squares;
+    for (int8_t y = 0; y < 8; ++y) {
+        for (int8_t x = 0; x < 8; ++x) {
+            if (this->grid[y][x]) {
+                squares.emplace_back(x, y);
+            }
+        }
+    }
+    const auto piece_count = static_cast<uint8_t>(squares.size());
+    out.write(reinterpret_cast<const char *>(&piece_count), sizeof(piece_count));
+    for (const BoardPos &pos : squares) {
+        Piece &piece = *this->grid[pos.y][pos.x];
+        const char data[5] = {
+            static_cast<char>(pos.x), static_cast<char>(pos.y), static_cast<char>(piece.white),
+            static_cast<char>(piece.has_moved), piece.getSymbol(),
+        };
+        out.write(data, sizeof(data));
+    }
+}
+
+void Board::readPieces(std::istream &in)
+{
+    for (auto &row : this->grid) {
+        for (auto &cell : row) {
+            cell.reset();
+        }
+    }
+    std::array<bool, 2> has_king{};
+    uint8_t piece_count = 0;
+    in.read(reinterpret_cast<char *>(&piece_count), sizeof(piece_count));
+    for (int i = 0; i < piece_count; ++i) {
+        char data[5];
+        if (!in.read(data, sizeof(data))) {
+            throw std::invalid_argument("position data is truncated");
+        }
+        const BoardPos pos = {data[0], data[1]};
+        const bool white = data[2];
+        const bool has_moved = data[3];
+        if (!pos.isWithinGrid() || std::string_view("PNBRQK").find(data[4]) == std::string_view::npos) {
+            throw std::invalid_argument("loaded invalid piece");
+        }
+        auto piece = createPiece(data[4], white, has_moved);
+        if (data[4] == 'K') {
+            this->kings[white] = std::static_pointer_cast<King>(piece);
+            has_king[white] = true;
+        } else if (data[4] == 'R' && !has_moved && pos.y == (white ? 0 : 7) && (pos.x == 0 || pos.x == 7)) {
+            this->initial_rooks[(white ? 2 : 0) + (pos.x == 7)] = std::static_pointer_cast<Rook>(piece);
+        }
+        this->setPiece(pos, std::move(piece));
+    }
+    if (!has_king[0] || !has_king[1]) {
+        throw std::invalid_argument("position needs both kings");
+    }
+    this->resetHistory();
+}
+
+void Board::readFen(const std::string &fen)
+{
+    std::istringstream in(fen);
+    std::string placement, side = "w", castling = "-", en_passant = "-";
+    int halfmove_clock = 0;
+    in >> placement >> side >> castling >> en_passant >> halfmove_clock;
+    if (side != "w" && side != "b") {
+        throw std::invalid_argument("invalid FEN side to move: " + fen);
+    }
+    if (castling != "-" && castling.find_first_not_of("KQkq") != std::string::npos) {
+        throw std::invalid_argument("invalid FEN castling rights: " + fen);
+    }
+
+    for (auto &row : this->grid) {
+        for (auto &cell : row) {
+            cell.reset();
+        }
+    }
+    std::array<int, 2> king_count{};
+    std::array<BoardPos, 2> king_squares{};
+    int8_t x = 0;
+    int8_t y = 7;
+    for (const char c : placement) {
+        if (c == '/') {
+            if (x != 8) {
+                throw std::invalid_argument("invalid FEN rank: " + fen);
+            }
+            --y;
+            x = 0;
+            continue;
+        }
+        if (c >= '1' && c <= '8') {
+            x = static_cast<int8_t>(x + c - '0');
+        } else {
+            const char symbol = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+            if (std::string_view("PNBRQK").find(symbol) == std::string_view::npos || x > 7 || y < 0) {
+                throw std::invalid_argument("invalid FEN piece placement: " + fen);
+            }
+            const bool white = symbol == c;
+            if (symbol == 'P' && (y == 0 || y == 7)) {
+                throw std::invalid_argument("invalid FEN pawn on the first or last rank: " + fen);
+            }
+            // Only kings and rooks that may still castle count as unmoved, see below
+            auto piece = createPiece(symbol, white, true);
+            if (symbol == 'K') {
+                this->kings[white] = std::static_pointer_cast<King>(piece);
+                ++king_count[white];
+                king_squares[white] = {x, y};
+            }
+            this->setPiece({x, y}, std::move(piece));
+            ++x;
+        }
+        if (x > 8) {
+            throw std::invalid_argument("invalid FEN rank: " + fen);
+        }
+    }
+    if (y != 0 || x != 8) {
+        throw std::invalid_argument("invalid FEN piece placement: " + fen);
+    }
+    if (king_count[0] != 1 || king_count[1] != 1) {
+        throw std::invalid_argument("FEN needs one king of each color: " + fen);
+    }
+
+    for (const bool white : {false, true}) {
+        const int8_t rank = white ? 0 : 7;
+        bool can_castle = false;
+        for (const bool short_side : {false, true}) {
+            const char right = short_side ? (white ? 'K' : 'k') : (white ? 'Q' : 'q');
+            const auto &corner = this->grid[rank][short_side ? 7 : 0];
+            const bool valid = castling.find(right) != std::string::npos && corner && corner->white == white
+                               && corner->getSymbol() == 'R' && this->grid[rank][4] == this->kings[white];
+            if (valid) {
+                corner->has_moved = false;
+                this->initial_rooks[(white ? 2 : 0) + short_side] = std::static_pointer_cast<Rook>(corner);
+                can_castle = true;
+            }
+        }
+        this->kings[white]->has_moved = !can_castle;
+    }
+
+    this->white_to_move = side == "w";
+    this->resetHistory();
+    // The side that just moved cannot have left its king in check, searching such a position would capture a king
+    if (is_attacked(*this, king_squares[!this->white_to_move], this->white_to_move)) {
+        throw std::invalid_argument("FEN side not to move is in check: " + fen);
+    }
+    if (en_passant != "-") {
+        // FEN names the square behind the pawn that just moved two squares
+        const BoardPos target = parseBoardPos(en_passant);
+        const BoardPos pushed = {target.x, static_cast<int8_t>(this->white_to_move ? 4 : 3)};
+        const auto &pawn = this->getPiece(pushed);
+        if (target.y != (this->white_to_move ? 5 : 2) || this->getPiece(target) || !pawn
+            || pawn->white == this->white_to_move || pawn->getSymbol() != 'P') {
+            throw std::invalid_argument("invalid FEN en passant square: " + fen);
+        }
+        // Kept only if a pawn can capture, like makeMove does, so the hash matches the same position reached by moves
+        for (const int8_t side : {-1, 1}) {
+            const BoardPos neighbour = {static_cast<int8_t>(pushed.x + side), pushed.y};
+            if (!neighbour.isWithinGrid()) continue;
+            const auto &capturer = this->getPiece(neighbour);
+            if (capturer && capturer->white == this->white_to_move && capturer->getSymbol() == 'P') {
+                this->en_passant = target;
+                break;
+            }
+        }
+    }
+    this->halfmove_clock = static_cast<uint16_t>(std::clamp(halfmove_clock, 0, 100));
+    this->hash = this->computeHash();
+}
+
+uint64_t Board::computeHash() const
+{
+    uint64_t key = castling_key(*this);
+    for (int8_t y = 0; y < 8; ++y)
+    {
+        for (int8_t x = 0; x < 8; ++x)
+        {
+            if (const auto &piece = this->grid[y][x]) {
+                key ^= piece_key(*piece, {x, y});
+            }
+        }
+    }
+    if (!this->white_to_move) {
+        key ^= zobrist_keys.black_to_move;
+    }
+    if (this->en_passant.isWithinGrid()) {
+        key ^= zobrist_keys.en_passant_file[this->en_passant.x];
+    }
+    return key;
+}
+
+uint64_t Board::computePawnHash() const
+{
+    uint64_t key = 0;
+    for (int8_t y = 0; y < 8; ++y)
+    {
+        for (int8_t x = 0; x < 8; ++x)
+        {
+            const auto &piece = this->grid[y][x];
+            if (piece && in_pawn_hash(*piece)) {
+                key ^= piece_key(*piece, {x, y});
+            }
+        }
+    }
+    return key;
+}
+
+bool Board::isRepetition(const int search_ply) const
+{
+    // Positions before the last capture or pawn move can never come back
+    const size_t reversible_plies = std::min<size_t>(this->halfmove_clock, this->history.size());
+    int repetitions = 0;
+    for (size_t ply = 4; ply <= reversible_plies; ply += 2) {
+        if (this->history[this->history.size() - ply].hash != this->hash) continue;
+        if (ply <= static_cast<size_t>(search_ply)) return true;
+        if (++repetitions == 2) return true;
+    }
+    return false;
+}
+
+bool Board::isFiftyMoveDraw() const
+{
+    return this->halfmove_clock >= 100;
+}
+
+void Board::draw(const SquareSet &marked_cells, const std::array<std::string, 8> &rank_notes) const
 {
     std::cout << "┏━━━━━━━━━━━━━━━━━━━┓" << std::endl;
     std::cout << "┃  a b c d e f g h  ┃" << std::endl;
@@ -91,18 +530,31 @@ void Board::draw(const std::set<BoardPos> &marked_cells) const
                 std::cout << "  ";
             }
         }
-        std::cout << " " << std::to_string(y+1) << "┃" << std::endl;
+        std::cout << " " << std::to_string(y+1) << "┃" << rank_notes[y] << std::endl;
     }
     std::cout << "┃  a b c d e f g h  ┃" << std::endl;
     std::cout << "┗━━━━━━━━━━━━━━━━━━━┛" << std::endl;
 }
 
+std::shared_ptr<Piece> Board::takePromotionPiece(const char symbol, const bool white) {
+    const auto spare = std::ranges::find_if(this->spare_pieces, [symbol, white](const std::shared_ptr<Piece> &piece) {
+        return piece->getSymbol() == symbol && piece->white == white && piece.use_count() == 1;
+    });
+    if (spare == this->spare_pieces.end()) {
+        return createPiece(symbol, white, true);
+    }
+    std::shared_ptr<Piece> piece = std::move(*spare);
+    this->spare_pieces.erase(spare);
+    piece->has_moved = true;
+    return piece;
+}
+
 std::shared_ptr<Piece> &Board::getPiece(const BoardPos &pos) {
     return this->grid[pos.y][pos.x];
 }
 
 void Board::setPiece(const BoardPos &pos, std::shared_ptr<Piece> &&piece) {
-    this->grid[pos.y][pos.x] = piece;
+    this->grid[pos.y][pos.x] = std::move(piece);
 }
 
 BoardPos Board::getPos(const Piece &piece) const {
@@ -123,7 +575,7 @@ King & Board::getKing(const bool white) const {
 }
 
 Rook & Board::getInitialRook(const bool white, const bool short_side) const {
-    return *this->initial_rooks[white * 2 + short_side];
+    return white ? this->getInitialRook<Color::WHITE>(short_side) : this->getInitialRook<Color::BLACK>(short_side);
 }
 
 Move convertMove(const std::string &input)
@@ -140,7 +592,18 @@ Move convertMove(const std::string &input)
     if (input == "l") {
         return Move(true);
     }
-    if (input.size() > 4 || input.size() < 2)
+    if (input == "u" || input == "r") {
+        Move move;
+        move.undo = input == "u";
+        move.redo = input == "r";
+        return move;
+    }
+    if (input == "explore") {
+        Move move;
+        move.explore = true;
+        return move;
+    }
+    if (input.size() > 5 || input.size() < 2)
     {
         throw std::invalid_argument("invalid move input");
     }
@@ -148,8 +611,30 @@ Move convertMove(const std::string &input)
     if (input.size() == 4)
     {
         BoardPos fromPos = parseBoardPos(input.substr(0, 2));
-        BoardPos toPos = parseBoardPos(input.substr(2, 4));
+        BoardPos toPos = parseBoardPos(input.substr(2, 2));
         return {fromPos, toPos};
     }
+    if (input.size() == 5)
+    {
+        const char promotion = static_cast<char>(std::toupper(static_cast<unsigned char>(input[4])));
+        if (promotion != 'Q' && promotion != 'R' && promotion != 'B' && promotion != 'N')
+        {
+            throw std::invalid_argument("invalid promotion piece");
+        }
+        return {parseBoardPos(input.substr(0, 2)), parseBoardPos(input.substr(2, 2)), promotion};
+    }
     throw std::invalid_argument("invalid move input");
+}
+
+std::string formatMove(const Move &move)
+{
+    if (move.castling) {
+        return move.castling == 1 ? "O-O" : "O-O-O";
+    }
+    std::string result = {static_cast<char>('a' + move.from.x), static_cast<char>('1' + move.from.y),
+                          static_cast<char>('a' + move.to.x), static_cast<char>('1' + move.to.y)};
+    if (move.promotion) {
+        result += static_cast<char>(std::tolower(static_cast<unsigned char>(move.promotion)));
+    }
+    return result;
 }
\ No newline at end of file
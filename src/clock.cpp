@@ -0,0 +1,77 @@
+#include "chess-tui/clock.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    // Kept in reserve for input handling and printing between moves
+    constexpr GameClock::duration move_overhead{30};
+}
+
+GameClock::GameClock(const duration base, const duration increment) : left{base, base}, increment(increment) {
+}
+
+void GameClock::start(const bool white) {
+    this->running = true;
+    this->running_white = white;
+    this->started = std::chrono::steady_clock::now();
+}
+
+bool GameClock::stop() {
+    const duration left = this->remaining(this->running_white);
+    this->running = false;
+    if (left <= duration::zero()) {
+        this->left[this->running_white] = duration::zero();
+        return false;
+    }
+    this->left[this->running_white] = left + this->increment;
+    return true;
+}
+
+GameClock::duration GameClock::remaining(const bool white) const {
+    if (!this->running || white != this->running_white) {
+        return this->left[white];
+    }
+    const auto elapsed = std::chrono::duration_cast<duration>(std::chrono::steady_clock::now() - this->started);
+    return this->left[white] - elapsed;
+}
+
+GameClock::duration GameClock::getIncrement() const {
+    return this->increment;
+}
+
+GameClock GameClock::parse(const std::string &time_control) {
+    const size_t plus = time_control.find('+');
+    try {
+        size_t used = 0;
+        const double minutes = std::stod(time_control.substr(0, plus), &used);
+        const double seconds = plus == std::string::npos ? 0 : std::stod(time_control.substr(plus + 1));
+        if (minutes <= 0 || seconds < 0 || used != std::min(plus, time_control.size())) {
+            throw std::invalid_argument(time_control);
+        }
+        return {duration(static_cast<int64_t>(minutes * 60000)), duration(static_cast<int64_t>(seconds * 1000))};
+    } catch (std::logic_error &) {
+        throw std::invalid_argument("invalid time control " + time_control + ", expected minutes+increment");
+    }
+}
+
+/*
+ * Plans for about 30 more moves, of which every one brings its increment. The hard limit allows
+ * a few times the target but never more than a fraction of what is left.
+ */
+TimeBudget allocate_time(const GameClock::duration remaining, const GameClock::duration increment) {
+    const GameClock::duration usable = std::max(remaining - move_overhead, GameClock::duration(1));
+    const GameClock::duration soft = std::max(std::min(usable / 30 + increment * 3 / 4, usable / 2), GameClock::duration(1));
+    const GameClock::duration hard = std::min(soft * 4, usable / 3 + increment / 2);
+    return {soft, std::max(hard, soft)};
+}
+
+std::string format_clock(const GameClock::duration time) {
+    const int64_t tenths = std::max<int64_t>(time.count(), 0) / 100;
+    std::ostringstream out;
+    out << std::setfill('0') << std::setw(2) << tenths / 600 << ':' << std::setw(2) << tenths / 10 % 60 << '.'
+            << tenths % 10;
+    return out.str();
+}
@@ -0,0 +1,36 @@
+#include "chess-tui/evaluation.hpp"
+
+#include "chess-tui/eval-params.hpp"
+#include "chess-tui/pawn-structure.hpp"
+#include "chess-tui/zobrist.hpp"
+
+int evaluate(Board &board) {
+    int score = 0;
+    std::array<SquareSet, 2> pawns;
+    std::array<BoardPos, 2> kings;
+    for (int8_t y = 0; y < 8; ++y) {
+        for (int8_t x = 0; x < 8; ++x) {
+            const auto &piece = board.getPiece({x, y});
+            if (!piece) continue;
+            const uint8_t type = piece_type_index(piece->getSymbol());
+            const int square = (piece->white ? y : 7 - y) * 8 + x;
+            const int value = piece_values[type] + piece_square_tables[type][square];
+            score += piece->white ? value : -value;
+            if (type == 0) {
+                pawns[piece->white].insert({x, y});
+            } else if (type == 5) {
+                kings[piece->white] = {x, y};
+            }
+        }
+    }
+
+    // Pawn structure rarely changes between neighbouring nodes, so it is looked up by the pawn hash first
+    PawnCache &cache = PawnCache::local();
+    int pawn_score;
+    if (!cache.probe(board.pawn_hash, pawn_score)) {
+        pawn_score = pawn_structure_score(count_pawn_features(pawns, kings));
+        cache.store(board.pawn_hash, pawn_score);
+    }
+    score += pawn_score;
+    return board.white_to_move ? score : -score;
+}
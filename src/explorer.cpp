@@ -0,0 +1,329 @@
+#include "chess-tui/explorer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "chess-tui/board.hpp"
+#include "chess-tui/move-generator.hpp"
+#include "chess-tui/player.hpp"
+#include "chess-tui/transposition-table.hpp"
+
+namespace {
+    struct IndexHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t entry_count;
+    };
+    static_assert(sizeof(IndexHeader) == 16);
+
+    // Archives are split into pieces of about this size at line breaks, workers claim them one by one
+    constexpr size_t chunk_bytes = 1 << 20;
+    // A worker sorts and merges its new records whenever this many have piled up
+    constexpr size_t run_entries = 1 << 20;
+
+    /* Read-only mapping of a whole archive, empty files are not mapped */
+    class ArchiveMapping
+    {
+    public:
+        explicit ArchiveMapping(const std::string &path) {
+            const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                throw std::runtime_error("cannot open archive " + path);
+            }
+            struct stat info{};
+            if (fstat(fd, &info) < 0) {
+                close(fd);
+                throw std::runtime_error("cannot read archive " + path);
+            }
+            this->size = static_cast<size_t>(info.st_size);
+            if (this->size > 0) {
+                this->data = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+            }
+            close(fd);
+            if (this->data == MAP_FAILED) {
+                this->data = nullptr;
+                throw std::runtime_error("cannot map archive " + path);
+            }
+            if (this->data) {
+                madvise(this->data, this->size, MADV_SEQUENTIAL);
+            }
+        }
+
+        ~ArchiveMapping() {
+            if (this->data) {
+                munmap(this->data, this->size);
+            }
+        }
+
+        ArchiveMapping(const ArchiveMapping &) = delete;
+        ArchiveMapping &operator=(const ArchiveMapping &) = delete;
+
+        [[nodiscard]] std::string_view text() const {
+            return {static_cast<const char *>(this->data), this->size};
+        }
+
+    private:
+        void *data = nullptr;
+        size_t size = 0;
+    };
+
+    bool entry_less(const ExplorerEntry &a, const ExplorerEntry &b) {
+        return a.hash != b.hash ? a.hash < b.hash : a.move < b.move;
+    }
+
+    bool same_key(const ExplorerEntry &a, const ExplorerEntry &b) {
+        return a.hash == b.hash && a.move == b.move;
+    }
+
+    void add_counts(ExplorerEntry &into, const ExplorerEntry &from) {
+        into.white_wins += from.white_wins;
+        into.draws += from.draws;
+        into.black_wins += from.black_wins;
+    }
+
+    /* Sorts the records and sums up the ones for the same position and move */
+    void compact(std::vector<ExplorerEntry> &entries) {
+        std::ranges::sort(entries, entry_less);
+        size_t kept = 0;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (kept > 0 && same_key(entries[kept - 1], entries[i])) {
+                add_counts(entries[kept - 1], entries[i]);
+            } else {
+                entries[kept++] = entries[i];
+            }
+        }
+        entries.resize(kept);
+    }
+
+    /* Merges two compacted runs into one */
+    std::vector<ExplorerEntry> merge_runs(const std::vector<ExplorerEntry> &a, const std::vector<ExplorerEntry> &b) {
+        std::vector<ExplorerEntry> merged;
+        merged.reserve(a.size() + b.size());
+        size_t i = 0;
+        size_t j = 0;
+        while (i < a.size() && j < b.size()) {
+            if (same_key(a[i], b[j])) {
+                merged.push_back(a[i++]);
+                add_counts(merged.back(), b[j++]);
+            } else if (entry_less(a[i], b[j])) {
+                merged.push_back(a[i++]);
+            } else {
+                merged.push_back(b[j++]);
+            }
+        }
+        merged.insert(merged.end(), a.begin() + static_cast<std::ptrdiff_t>(i), a.end());
+        merged.insert(merged.end(), b.begin() + static_cast<std::ptrdiff_t>(j), b.end());
+        return merged;
+    }
+
+    /*
+     * Appends one record per indexed ply of the game on line. Returns false and appends nothing
+     * if the game has no result or one of its indexed moves cannot be played.
+     */
+    bool replay_game(const std::string_view line, const int max_plies, std::vector<ExplorerEntry> &out) {
+        std::vector<std::string_view> tokens;
+        for (size_t pos = 0; pos < line.size();) {
+            const size_t begin = line.find_first_not_of(" \t\r", pos);
+            if (begin == std::string_view::npos) break;
+            const size_t end = std::min(line.find_first_of(" \t\r", begin), line.size());
+            tokens.push_back(line.substr(begin, end - begin));
+            pos = end;
+        }
+        if (tokens.empty()) {
+            return false;
+        }
+        const std::string_view result = tokens.back();
+        tokens.pop_back();
+        ExplorerEntry counts{};
+        if (result == "1-0") {
+            counts.white_wins = 1;
+        } else if (result == "0-1") {
+            counts.black_wins = 1;
+        } else if (result == "1/2-1/2") {
+            counts.draws = 1;
+        } else {
+            return false;
+        }
+
+        const size_t first = out.size();
+        Board board;
+        const size_t plies = std::min(tokens.size(), static_cast<size_t>(std::max(max_plies, 0)));
+        try {
+            for (size_t ply = 0; ply < plies; ++ply) {
+                Move move = convertMove(std::string(tokens[ply]));
+                const LegalityMasks masks = compute_legality_masks(board, board.white_to_move);
+                if (move.isCommand() || move_rejection(board, masks, move)) {
+                    out.resize(first);
+                    return false;
+                }
+                ExplorerEntry entry = counts;
+                entry.hash = board.hash;
+                entry.move = encode_move(move);
+                out.push_back(entry);
+                board.makeMove(move);
+            }
+        } catch (std::invalid_argument &) {
+            out.resize(first);
+            return false;
+        }
+        return true;
+    }
+
+    struct WorkerOutput
+    {
+        std::vector<std::vector<ExplorerEntry>> runs;
+        uint64_t games = 0;
+        uint64_t skipped = 0;
+    };
+}
+
+IndexBuildStats build_opening_index(const std::vector<std::string> &archive_paths, const std::string &index_path,
+                                    const IndexBuildOptions &options) {
+    std::vector<std::unique_ptr<ArchiveMapping>> archives;
+    std::vector<std::string_view> chunks;
+    for (const std::string &path : archive_paths) {
+        const std::string_view text = archives.emplace_back(std::make_unique<ArchiveMapping>(path))->text();
+        for (size_t begin = 0; begin < text.size();) {
+            size_t end = std::min(begin + chunk_bytes, text.size());
+            end = std::min(text.find('\n', end - 1), text.size() - 1) + 1;
+            chunks.push_back(text.substr(begin, end - begin));
+            begin = end;
+        }
+    }
+
+    const unsigned thread_count = options.threads ? options.threads : std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<WorkerOutput> outputs(std::max<size_t>(std::min<size_t>(thread_count, chunks.size()), 1));
+    std::atomic<size_t> next_chunk = 0;
+    auto worker = [&](WorkerOutput &output) {
+        std::vector<ExplorerEntry> pending;
+        auto flush = [&] {
+            compact(pending);
+            output.runs.push_back(std::move(pending));
+            pending.clear();
+        };
+        for (size_t index; (index = next_chunk.fetch_add(1)) < chunks.size();) {
+            const std::string_view chunk = chunks[index];
+            for (size_t begin = 0; begin < chunk.size();) {
+                const size_t end = std::min(chunk.find('\n', begin), chunk.size());
+                const std::string_view line = chunk.substr(begin, end - begin);
+                begin = end + 1;
+                if (line.find_first_not_of(" \t\r") == std::string_view::npos) continue;
+                if (replay_game(line, options.max_plies, pending)) {
+                    ++output.games;
+                } else {
+                    ++output.skipped;
+                }
+                if (pending.size() >= run_entries) {
+                    flush();
+                }
+            }
+        }
+        if (!pending.empty()) {
+            flush();
+        }
+    };
+    {
+        std::vector<std::jthread> pool;
+        for (WorkerOutput &output : outputs) {
+            pool.emplace_back(worker, std::ref(output));
+        }
+    }
+
+    IndexBuildStats stats;
+    std::vector<std::vector<ExplorerEntry>> runs;
+    for (WorkerOutput &output : outputs) {
+        stats.games += output.games;
+        stats.skipped += output.skipped;
+        std::ranges::move(output.runs, std::back_inserter(runs));
+    }
+    // Pairwise rounds, so every record is copied about log2(runs) times
+    while (runs.size() > 1) {
+        std::vector<std::vector<ExplorerEntry>> merged;
+        for (size_t i = 0; i + 1 < runs.size(); i += 2) {
+            merged.push_back(merge_runs(runs[i], runs[i + 1]));
+            runs[i].clear();
+            runs[i].shrink_to_fit();
+            runs[i + 1].clear();
+            runs[i + 1].shrink_to_fit();
+        }
+        if (runs.size() % 2) {
+            merged.push_back(std::move(runs.back()));
+        }
+        runs = std::move(merged);
+    }
+    const std::vector<ExplorerEntry> entries = runs.empty() ? std::vector<ExplorerEntry>() : std::move(runs.front());
+    stats.entries = entries.size();
+
+    // Written next to the old index and renamed over it, so readers never see half a file
+    const std::string temporary_path = index_path + ".tmp";
+    std::ofstream fout(temporary_path, std::ios::binary | std::ios::trunc);
+    IndexHeader header{{'C', 'T', 'O', 'X'}, 1, entries.size()};
+    fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    fout.write(reinterpret_cast<const char *>(entries.data()),
+               static_cast<std::streamsize>(entries.size() * sizeof(ExplorerEntry)));
+    fout.close();
+    if (!fout || std::rename(temporary_path.c_str(), index_path.c_str()) != 0) {
+        std::remove(temporary_path.c_str());
+        throw std::runtime_error("cannot write index " + index_path);
+    }
+    return stats;
+}
+
+OpeningIndex::OpeningIndex(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open index " + path);
+    }
+    struct stat info{};
+    if (fstat(fd, &info) < 0 || static_cast<size_t>(info.st_size) < sizeof(IndexHeader)) {
+        close(fd);
+        throw std::runtime_error("index " + path + " is too short");
+    }
+    this->mapping_size = static_cast<size_t>(info.st_size);
+    this->mapping = mmap(nullptr, this->mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (this->mapping == MAP_FAILED) {
+        this->mapping = nullptr;
+        throw std::runtime_error("cannot map index " + path);
+    }
+    // Lookups touch a few pages at random, read-ahead would only evict other pages
+    madvise(this->mapping, this->mapping_size, MADV_RANDOM);
+
+    IndexHeader header{};
+    std::memcpy(&header, this->mapping, sizeof(header));
+    if (std::memcmp(header.magic, "CTOX", 4) != 0 || header.version != 1
+        || header.entry_count != (this->mapping_size - sizeof(header)) / sizeof(ExplorerEntry)
+        || (this->mapping_size - sizeof(header)) % sizeof(ExplorerEntry) != 0) {
+        munmap(this->mapping, this->mapping_size);
+        this->mapping = nullptr;
+        throw std::runtime_error("index " + path + " has an unsupported header");
+    }
+    const auto *first = reinterpret_cast<const ExplorerEntry *>(static_cast<const char *>(this->mapping) + sizeof(header));
+    this->entries = {first, header.entry_count};
+}
+
+OpeningIndex::~OpeningIndex() {
+    if (this->mapping) {
+        munmap(this->mapping, this->mapping_size);
+    }
+}
+
+std::span<const ExplorerEntry> OpeningIndex::lookup(const uint64_t hash) const {
+    const auto range = std::ranges::equal_range(this->entries, hash, std::ranges::less{}, &ExplorerEntry::hash);
+    return {range.begin(), range.end()};
+}
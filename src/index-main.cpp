@@ -0,0 +1,43 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "chess-tui/explorer.hpp"
+
+int main(int argc, char *argv[]) {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+    std::vector<std::string> archive_paths;
+    std::string output_path = "openings.idx";
+    IndexBuildOptions options;
+    bool valid = true;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const bool has_value = i + 1 < args.size();
+        if (args[i] == "--output" && has_value) {
+            output_path = args[++i];
+        } else if (args[i] == "--plies" && has_value) {
+            options.max_plies = std::stoi(args[++i]);
+        } else if (args[i] == "--threads" && has_value) {
+            options.threads = std::stoi(args[++i]);
+        } else if (!args[i].starts_with("--")) {
+            archive_paths.push_back(args[i]);
+        } else {
+            valid = false;
+            break;
+        }
+    }
+    if (!valid || archive_paths.empty()) {
+        std::cerr << "Usage: chess_index <archive>... [--output openings.idx] [--plies N] [--threads N]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        const IndexBuildStats stats = build_opening_index(archive_paths, output_path, options);
+        std::cout << "Indexed " << stats.games << " games (" << stats.skipped << " skipped), " << stats.entries
+                << " entries" << std::endl;
+    } catch (std::runtime_error &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Wrote " << output_path << std::endl;
+    return EXIT_SUCCESS;
+}
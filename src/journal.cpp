@@ -0,0 +1,329 @@
+#include "chess-tui/journal.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "chess-tui/move-generator.hpp"
+#include "chess-tui/player.hpp"
+#include "chess-tui/transposition-table.hpp"
+
+namespace {
+    constexpr char journal_magic[4] = {'C', 'T', 'J', 'N'};
+    constexpr char snapshot_magic[4] = {'C', 'T', 'S', 'N'};
+    constexpr size_t header_size = 8;
+    // A write reaches the page cache right away, so a crash of the program loses nothing.
+    // Syncing only every few records bounds what a power loss can take.
+    constexpr uint32_t sync_interval = 8;
+    constexpr uint32_t snapshot_interval = 64;
+    constexpr uint16_t undo_record = 0;
+
+    void put_u16(std::string &out, const uint16_t value) {
+        out += static_cast<char>(value & 0xFF);
+        out += static_cast<char>(value >> 8);
+    }
+
+    void put_u32(std::string &out, const uint32_t value) {
+        put_u16(out, static_cast<uint16_t>(value & 0xFFFF));
+        put_u16(out, static_cast<uint16_t>(value >> 16));
+    }
+
+    uint16_t get_u16(std::istream &in) {
+        unsigned char bytes[2];
+        if (!in.read(reinterpret_cast<char *>(bytes), sizeof(bytes))) {
+            throw std::runtime_error("snapshot is truncated");
+        }
+        return static_cast<uint16_t>(bytes[0] | bytes[1] << 8);
+    }
+
+    uint32_t get_u32(std::istream &in) {
+        const uint16_t low = get_u16(in);
+        return low | static_cast<uint32_t>(get_u16(in)) << 16;
+    }
+
+    void write_all(const int fd, const std::string &data, const std::string &path) {
+        for (size_t written = 0; written < data.size();) {
+            const ssize_t result = write(fd, data.data() + written, data.size() - written);
+            if (result < 0) {
+                throw std::runtime_error("cannot write " + path + ": " + std::strerror(errno));
+            }
+            written += static_cast<size_t>(result);
+        }
+    }
+
+    /*
+     * Makes a rename in the directory of path survive a crash, the file's own fsync does not cover its name
+     */
+    void sync_directory(const std::string &path) {
+        const size_t slash = path.rfind('/');
+        const std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+        const int directory_fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (directory_fd < 0 || fsync(directory_fd) < 0) {
+            const std::string reason = std::strerror(errno);
+            if (directory_fd >= 0) {
+                close(directory_fd);
+            }
+            throw std::runtime_error("cannot sync " + directory + ": " + reason);
+        }
+        close(directory_fd);
+    }
+
+    /*
+     * Decodes a move and makes sure it is legal in the current position
+     */
+    Move checked_move(Board &board, const uint16_t record) {
+        const Move move = decode_move(record);
+        const std::vector<Move> legal_moves = generate_legal_moves(board, board.white_to_move);
+        if (std::ranges::find(legal_moves, move) == legal_moves.end()) {
+            throw std::runtime_error("journal contains an illegal move: " + formatMove(move));
+        }
+        return move;
+    }
+}
+
+GameJournal::GameJournal(std::string prefix) : journal_path(prefix + ".journal"), snapshot_path(prefix + ".snapshot") {
+}
+
+GameJournal::~GameJournal() {
+    if (this->fd >= 0) {
+        fdatasync(this->fd);
+        close(this->fd);
+    }
+}
+
+bool GameJournal::recover(Board &board) {
+    std::ifstream snapshot(this->snapshot_path, std::ios::binary);
+    if (!snapshot) return false;
+
+    char magic[4];
+    if (!snapshot.read(magic, sizeof(magic)) || std::memcmp(magic, snapshot_magic, sizeof(magic)) != 0) {
+        throw std::runtime_error(this->snapshot_path + " is not a snapshot");
+    }
+    const uint32_t snapshot_generation = get_u32(snapshot);
+    board.white_to_move = snapshot.get() == 1;
+    try {
+        board.readPieces(snapshot);
+    } catch (std::invalid_argument &e) {
+        throw std::runtime_error(this->snapshot_path + ": " + e.what());
+    }
+    std::ostringstream start;
+    board.writePieces(start);
+    this->start_position = start.str();
+    this->start_white_to_move = board.white_to_move;
+    for (uint16_t count = get_u16(snapshot); count > 0; --count) {
+        board.makeMove(checked_move(board, get_u16(snapshot)));
+    }
+    this->redo_moves.clear();
+    for (uint16_t count = get_u16(snapshot); count > 0; --count) {
+        this->redo_moves.push_back(decode_move(get_u16(snapshot)));
+    }
+
+    // Replay the journal if it continues this snapshot, a torn last record is dropped
+    this->generation = snapshot_generation + 1;
+    this->records = 0;
+    std::ifstream journal(this->journal_path, std::ios::binary);
+    bool continues = false;
+    if (journal && journal.read(magic, sizeof(magic)) && std::memcmp(magic, journal_magic, sizeof(magic)) == 0) {
+        const uint32_t journal_generation = get_u32(journal);
+        if (journal_generation > this->generation) {
+            throw std::runtime_error(this->journal_path + " is newer than " + this->snapshot_path);
+        }
+        continues = journal_generation == this->generation;
+    }
+    unsigned char bytes[2];
+    while (continues && journal.read(reinterpret_cast<char *>(bytes), sizeof(bytes))) {
+        const uint16_t record = static_cast<uint16_t>(bytes[0] | bytes[1] << 8);
+        if (record == undo_record) {
+            if (board.history.empty()) {
+                throw std::runtime_error(this->journal_path + " takes back more moves than were played");
+            }
+            this->redo_moves.push_back(board.history.back().move);
+            board.unmakeMove();
+        } else {
+            const Move move = checked_move(board, record);
+            if (!this->redo_moves.empty() && this->redo_moves.back() == move) {
+                this->redo_moves.pop_back();
+            } else {
+                this->redo_moves.clear();
+            }
+            board.makeMove(move);
+        }
+        ++this->records;
+    }
+    try {
+        this->openJournal(!continues);
+    } catch (std::runtime_error &e) {
+        this->disable(e);
+    }
+    return true;
+}
+
+void GameJournal::reset(const Board &board) {
+    std::ostringstream start;
+    board.writePieces(start);
+    this->start_position = start.str();
+    this->start_white_to_move = board.white_to_move;
+    this->redo_moves.clear();
+    this->writeSnapshot(board);
+}
+
+void GameJournal::clear() {
+    if (this->fd >= 0) {
+        close(this->fd);
+        this->fd = -1;
+    }
+    unlink(this->journal_path.c_str());
+    unlink(this->snapshot_path.c_str());
+}
+
+void GameJournal::makeMove(Board &board, const Move &move) {
+    // Playing the move that was taken back last keeps the remaining ones for redo
+    if (!this->redo_moves.empty() && this->redo_moves.back() == move) {
+        this->redo_moves.pop_back();
+    } else {
+        this->redo_moves.clear();
+    }
+    board.makeMove(move);
+    this->append(encode_move(move));
+    if (this->records >= snapshot_interval) {
+        this->writeSnapshot(board);
+    }
+}
+
+bool GameJournal::undo(Board &board) {
+    if (board.history.empty()) return false;
+    this->redo_moves.push_back(board.history.back().move);
+    board.unmakeMove();
+    this->append(undo_record);
+    if (this->records >= snapshot_interval) {
+        this->writeSnapshot(board);
+    }
+    return true;
+}
+
+bool GameJournal::redo(Board &board) {
+    if (this->redo_moves.empty()) return false;
+    const std::vector<Move> legal_moves = generate_legal_moves(board, board.white_to_move);
+    if (std::ranges::find(legal_moves, this->redo_moves.back()) == legal_moves.end()) {
+        // Only possible with a damaged snapshot
+        this->redo_moves.clear();
+        return false;
+    }
+    this->makeMove(board, this->redo_moves.back());
+    return true;
+}
+
+bool GameJournal::startsFromInitialPosition() const {
+    std::ostringstream initial;
+    Board().writePieces(initial);
+    return this->start_white_to_move && this->start_position == initial.str();
+}
+
+std::string GameJournal::takeWriteError() {
+    return std::exchange(this->write_error, {});
+}
+
+void GameJournal::disable(const std::runtime_error &error) {
+    if (this->fd >= 0) {
+        close(this->fd);
+        this->fd = -1;
+    }
+    this->autosave = false;
+    this->write_error = error.what();
+}
+
+void GameJournal::append(const uint16_t record) {
+    if (this->fd < 0) return;
+    std::string data;
+    put_u16(data, record);
+    try {
+        write_all(this->fd, data, this->journal_path);
+    } catch (std::runtime_error &e) {
+        this->disable(e);
+        return;
+    }
+    ++this->records;
+    if (++this->unsynced >= sync_interval) {
+        fdatasync(this->fd);
+        this->unsynced = 0;
+    }
+}
+
+/*
+ * Writes the whole game next to the old snapshot, syncs it and renames it over the old one,
+ * so there always is one complete snapshot. The journal then starts over one generation later.
+ */
+void GameJournal::writeSnapshot(const Board &board) {
+    if (!this->autosave) return;
+    std::string data(snapshot_magic, sizeof(snapshot_magic));
+    put_u32(data, this->generation);
+    data += static_cast<char>(this->start_white_to_move);
+    data += this->start_position;
+    put_u16(data, static_cast<uint16_t>(board.history.size()));
+    for (const UndoInfo &undo : board.history) {
+        put_u16(data, encode_move(undo.move));
+    }
+    put_u16(data, static_cast<uint16_t>(this->redo_moves.size()));
+    for (const Move &move : this->redo_moves) {
+        put_u16(data, encode_move(move));
+    }
+
+    const std::string temporary_path = this->snapshot_path + ".tmp";
+    int snapshot_fd = open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    try {
+        if (snapshot_fd < 0) {
+            throw std::runtime_error("cannot create " + temporary_path + ": " + std::strerror(errno));
+        }
+        write_all(snapshot_fd, data, temporary_path);
+        if (fsync(snapshot_fd) < 0) {
+            throw std::runtime_error("cannot sync " + temporary_path + ": " + std::strerror(errno));
+        }
+        close(snapshot_fd);
+        // The number may be reused right away, nothing below must close it again
+        snapshot_fd = -1;
+        if (rename(temporary_path.c_str(), this->snapshot_path.c_str()) < 0) {
+            const std::string reason = std::strerror(errno);
+            unlink(temporary_path.c_str());
+            throw std::runtime_error("cannot replace " + this->snapshot_path + ": " + reason);
+        }
+        // Before the journal is truncated, otherwise a crash could leave the old snapshot without its journal
+        sync_directory(this->snapshot_path);
+        ++this->generation;
+        this->records = 0;
+        this->openJournal(true);
+    } catch (std::runtime_error &e) {
+        if (snapshot_fd >= 0) {
+            close(snapshot_fd);
+            unlink(temporary_path.c_str());
+        }
+        this->disable(e);
+    }
+}
+
+void GameJournal::openJournal(const bool truncate) {
+    if (this->fd >= 0) {
+        close(this->fd);
+    }
+    this->fd = open(this->journal_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (this->fd < 0) {
+        throw std::runtime_error("cannot open " + this->journal_path + ": " + std::strerror(errno));
+    }
+    if (truncate) {
+        std::string header(journal_magic, sizeof(journal_magic));
+        put_u32(header, this->generation);
+        if (ftruncate(this->fd, 0) < 0) {
+            throw std::runtime_error("cannot truncate " + this->journal_path + ": " + std::strerror(errno));
+        }
+        write_all(this->fd, header, this->journal_path);
+    } else if (ftruncate(this->fd, static_cast<off_t>(header_size + 2 * this->records)) < 0) {
+        throw std::runtime_error("cannot truncate " + this->journal_path + ": " + std::strerror(errno));
+    }
+    fdatasync(this->fd);
+    this->unsynced = 0;
+}
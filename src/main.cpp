@@ -1,140 +1,449 @@
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <iomanip>
+#include <optional>
 
 #include "chess-tui/board.hpp"
 #include "chess-tui/piece.hpp"
 #include "chess-tui/vector.hpp"
 #include "chess-tui/piece-visitor.hpp"
+#include "chess-tui/move-generator.hpp"
+#include "chess-tui/analysis.hpp"
+#include "chess-tui/arena.hpp"
+#include "chess-tui/batch.hpp"
+#include "chess-tui/bench.hpp"
+#include "chess-tui/clock.hpp"
+#include "chess-tui/color.hpp"
+#include "chess-tui/explorer.hpp"
+#include "chess-tui/journal.hpp"
+#include "chess-tui/mate-solver.hpp"
+#include "chess-tui/pawn-structure.hpp"
 #include "chess-tui/player.hpp"
+#include "chess-tui/server.hpp"
+#include "chess-tui/transposition-table.hpp"
 
-void selectGamemode(Board &board, std::unique_ptr<Player> &player) {
+void selectGamemode(Board &board, TranspositionTable &tt, const NnueNetwork *network, const GameClock *clock,
+                    std::array<std::unique_ptr<Player>, 2> &players) {
+    players[1] = std::make_unique<LocalPlayer>();
     while (true) {
         std::cout << "Select Gamemode:" << std::endl;
         std::cout << "[1] Player vs Player" << std::endl;
         std::cout << "[2] Player vs Bot" << std::endl;
+        std::cout << "[3] Player vs Search Bot" << std::endl;
+        std::cout << "[4] Search Bot vs Search Bot" << std::endl;
         std::string input;
         std::cin >> input;
 
         if (input == "1") {
-            player = std::make_unique<LocalPlayer>();
+            players[0] = std::make_unique<LocalPlayer>();
             break;
         }
         if (input == "2") {
-            player = std::make_unique<BasicBotPlayer>(board, false);
+            players[0] = std::make_unique<BasicBotPlayer>(board, false);
+            break;
+        }
+        if (input == "3") {
+            players[0] = std::make_unique<SearchBotPlayer>(board, tt, SearchLimits{}, network, clock);
+            break;
+        }
+        if (input == "4") {
+            for (auto &player : players) {
+                player = std::make_unique<SearchBotPlayer>(board, tt, SearchLimits{}, network, clock);
+            }
             break;
         }
-        std::cout << "Please enter either 0 or 1" << std::endl;
+        std::cout << "Please enter either 1, 2, 3 or 4" << std::endl;
     }
 }
 
 /**
- * [1] x
- * [1] y
- * [1] white
- * [1] has_moved
- * [1] type
+ * Remaining time of each side next to its home rank, the running clock marked
  */
-void saveGame(Board &board, std::ofstream &fout) {
-    std::vector<std::shared_ptr<Piece>> pieces;
-    for (int8_t y = 0; y < 8; ++y) {
-        for (int8_t x = 0; x < 8; ++x) {
-            const auto & piece = board.getPiece({x, y});
-            if (!piece) continue;
-            pieces.push_back(piece);
-        }
-    }
-    uint8_t piece_count = pieces.size();
-    fout.write(reinterpret_cast<char *>(&piece_count), sizeof(piece_count));
-    for (const auto & piece : pieces) {
-        auto [x, y] = board.getPos(*piece);
-        fout.write(reinterpret_cast<char *>(&x), sizeof(x));
-        fout.write(reinterpret_cast<char *>(&y), sizeof(x));
-        uint8_t white = piece->white;
-        fout.write(reinterpret_cast<char *>(&white), sizeof(white));
-        uint8_t has_moved = piece->white;
-        fout.write(reinterpret_cast<char *>(&has_moved), sizeof(has_moved));
-        char symbol = piece->getSymbol();
-        fout.write(&symbol, sizeof(symbol));
-    }
+std::array<std::string, 8> clockNotes(const GameClock &clock, const bool white_to_move) {
+    std::array<std::string, 8> notes;
+    notes[7] = "  Player 2  " + format_clock(clock.remaining(false)) + (white_to_move ? "" : " ◀");
+    notes[0] = "  Player 1  " + format_clock(clock.remaining(true)) + (white_to_move ? " ◀" : "");
+    return notes;
 }
 
-void loadGame(Board &board, std::ifstream &fin) {
-    for (int8_t y = 0; y < 8; ++y) {
-        for (int8_t x = 0; x < 8; ++x) {
-            board.getPiece({x, y}).reset();
-        }
-    }
-    uint8_t piece_count;
-    fin.read(reinterpret_cast<char *>(&piece_count), sizeof(piece_count));
-    for (int i = 0; i < piece_count; ++i) {
-        int8_t x, y;
-        fin.read(reinterpret_cast<char *>(&x), sizeof(x));
-        fin.read(reinterpret_cast<char *>(&y), sizeof(y));
-        uint8_t white;
-        fin.read(reinterpret_cast<char *>(&white), sizeof(white));
-        uint8_t has_moved;
-        fin.read(reinterpret_cast<char *>(&has_moved), sizeof(has_moved));
-        char symbol;
-        fin.read(&symbol, sizeof(symbol));
-        switch (symbol) {
-            case 'P':
-                board.setPiece({x, y}, std::make_shared<Pawn>(white, has_moved));
-                break;
-            case 'R':
-                board.setPiece({x, y}, std::make_shared<Rook>(white, has_moved));
-                break;
-            case 'B':
-                board.setPiece({x, y}, std::make_shared<Bishop>(white, has_moved));
-                break;
-            case 'N':
-                board.setPiece({x, y}, std::make_shared<Knight>(white, has_moved));
-                break;
-            case 'K':
-                board.setPiece({x, y}, std::make_shared<King>(white, has_moved));
-                break;
-            case 'Q':
-                board.setPiece({x, y}, std::make_shared<Queen>(white, has_moved));
-                break;
-            default: throw std::invalid_argument("loaded invalid piece symbol");
-        }
+/**
+ * How the indexed games continued from the current position, most played move first,
+ * with the target squares of the moves marked on the board
+ */
+void explorePosition(const Board &board, const OpeningIndex *index, const std::array<std::string, 8> &notes) {
+    if (!index) {
+        std::cout << "No opening index loaded (--explorer <index>)" << std::endl;
+        return;
+    }
+    const std::span<const ExplorerEntry> found = index->lookup(board.hash);
+    if (found.empty()) {
+        std::cout << "Position not in the opening index" << std::endl;
+        return;
+    }
+    std::vector<ExplorerEntry> entries(found.begin(), found.end());
+    std::ranges::stable_sort(entries, std::greater{}, &ExplorerEntry::games);
+    const int8_t back_rank = board.white_to_move ? ColorTraits<Color::WHITE>::back_rank : ColorTraits<Color::BLACK>::back_rank;
+    SquareSet targets;
+    for (const ExplorerEntry &entry : entries) {
+        const Move move = decode_move(entry.move);
+        targets.insert(move.castling
+                           ? BoardPos{ColorTraits<Color::WHITE>::king_to_file[move.castling == 1], back_rank}
+                           : move.to);
+    }
+    board.draw(targets, notes);
+
+    uint64_t total = 0;
+    for (const ExplorerEntry &entry : entries) {
+        total += entry.games();
+    }
+    std::cout << total << " games" << std::endl;
+    std::cout << "Move      Games   White    Draw   Black" << std::endl;
+    auto percent = [](const uint64_t part, const uint64_t whole) {
+        return 100.0 * static_cast<double>(part) / static_cast<double>(whole);
+    };
+    for (const ExplorerEntry &entry : entries) {
+        const uint64_t games = entry.games();
+        std::cout << std::left << std::setw(6) << formatMove(decode_move(entry.move)) << std::right << std::setw(9)
+                << games << std::fixed << std::setprecision(1)
+                << std::setw(7) << percent(entry.white_wins, games) << '%'
+                << std::setw(7) << percent(entry.draws, games) << '%'
+                << std::setw(7) << percent(entry.black_wins, games) << '%' << std::endl;
     }
 }
 
-void saveGame(Board &board) {
+void saveGame(const Board &board) {
     std::ofstream fout;
     fout.open("chess.data", std::ios::binary | std::ios::out);
-    saveGame(board, fout);
+    board.writePieces(fout);
     fout.close();
 }
 void loadGame(Board &board) {
     std::ifstream fin;
     fin.open("chess.data", std::ios::binary | std::ios::in);
-    loadGame(board, fin);
+    // Read into a fresh board, so a missing or damaged file leaves the game untouched
+    Board loaded;
+    loaded.white_to_move = board.white_to_move;
+    loaded.readPieces(fin);
     fin.close();
+    board = std::move(loaded);
+}
+
+/**
+ * The moves played so far, readable by --analyze. Only meaningful for games started from the initial position.
+ */
+void saveGameRecord(const Board &board) {
+    std::ofstream fout;
+    fout.open("chess.moves", std::ios::out);
+    writeGameRecord(board, fout);
+    fout.close();
+}
+
+void printStats() {
+    const PawnCacheStats stats = PawnCache::totalStats();
+    const double hit_rate = stats.probes ? 100.0 * static_cast<double>(stats.hits) / static_cast<double>(stats.probes) : 0;
+    std::cout << "Pawn cache: " << stats.hits << " of " << stats.probes << " probes hit (" << std::fixed
+            << std::setprecision(1) << hit_rate << "%)" << std::endl;
+    if (counting_allocations) {
+        std::cout << "Heap allocations: " << global_allocation_count() << std::endl;
+    }
 }
 
-int main() {
+int analyze(const std::string &path, const AnalysisOptions &options) {
+    std::ifstream fin(path);
+    if (!fin) {
+        std::cerr << "Cannot open " << path << std::endl;
+        return EXIT_FAILURE;
+    }
+    try {
+        analyzeGame(readGameRecord(fin), options, std::cout);
+    } catch (std::invalid_argument &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * One FEN per line in, one answer per line out: the legal moves, the state or the best move with its score
+ */
+int runBatch(const std::string &path, const BatchOptions &options) {
+    std::ifstream fin(path);
+    if (!fin) {
+        std::cerr << "Cannot open " << path << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::vector<std::string> fens;
+    for (std::string line; std::getline(fin, line);) {
+        if (line.empty() || line == "\r") continue;
+        fens.push_back(line);
+    }
+    std::vector<BatchResult> results;
+    try {
+        results = query_positions(fens, options);
+    } catch (std::invalid_argument &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    constexpr std::array<const char *, 4> state_names = {"ongoing", "check", "checkmate", "stalemate"};
+    std::string out;
+    for (const BatchResult &result : results) {
+        switch (options.query) {
+            case BatchQuery::LEGAL_MOVES:
+                for (const Move &move : result.legal_moves) {
+                    if (&move != &result.legal_moves.front()) out += ' ';
+                    out += formatMove(move);
+                }
+                break;
+            case BatchQuery::GAME_STATE:
+                out += state_names[static_cast<int>(result.state)];
+                break;
+            case BatchQuery::BEST_MOVE:
+                out += result.best_move == Move() ? "-" : formatMove(result.best_move);
+                out += ' ' + std::to_string(result.score);
+                break;
+        }
+        out += '\n';
+    }
+    std::cout << out << std::flush;
+    return EXIT_SUCCESS;
+}
+
+int solveMate(const std::string &fen, const int moves, const bool shortest) {
+    if (moves > MAX_MATE_MOVES) {
+        std::cerr << "--mate supports at most " << MAX_MATE_MOVES << " moves" << std::endl;
+        return EXIT_FAILURE;
+    }
     Board board;
+    try {
+        board.readFen(fen);
+    } catch (std::invalid_argument &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    MateSolver solver(board);
+    const MateResult result = solver.solve(moves, shortest);
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    switch (result.outcome) {
+        case MateOutcome::MATE:
+            std::cout << "Mate in " << (result.shortest ? "" : "at most ") << result.moves << ":";
+            for (const Move &move : result.line) {
+                std::cout << ' ' << formatMove(move);
+            }
+            if (!result.line_complete) {
+                std::cout << " ... (out of memory before the end of the line)";
+            }
+            std::cout << std::endl;
+            break;
+        case MateOutcome::NO_MATE:
+            std::cout << "No mate in " << moves << std::endl;
+            break;
+        case MateOutcome::UNKNOWN:
+            std::cout << "Out of memory, no result" << std::endl;
+            break;
+    }
+    std::cout << result.nodes << " nodes in " << elapsed.count() << " ms" << std::endl;
+    return result.outcome == MateOutcome::UNKNOWN ? EXIT_FAILURE : EXIT_SUCCESS;
+}
 
-    std::array<std::unique_ptr<Player>, 2> players = {};
-    players[1] = std::make_unique<LocalPlayer>();
-    selectGamemode(board, players[0]);
+int main(int argc, char *argv[]) {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+    std::string analyze_path;
+    std::string serve_path;
+    std::string batch_path;
+    std::string fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    int mate_moves = 0;
+    bool shortest = false;
+    bool bench = false;
+    bool match = false;
+    BenchOptions bench_options;
+    MatchOptions match_options;
+    std::string network_path;
+    std::string explorer_path;
+    std::string time_control;
+    bool stats = false;
+    AnalysisOptions analysis_options;
+    ServerOptions server_options;
+    BatchOptions batch_options;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const bool has_value = i + 1 < args.size();
+        if (args[i] == "--analyze" && has_value) {
+            analyze_path = args[++i];
+        } else if (args[i] == "--serve" && has_value) {
+            serve_path = args[++i];
+        } else if (args[i] == "--batch" && has_value) {
+            batch_path = args[++i];
+        } else if (args[i] == "--query" && has_value && (args[i + 1] == "moves" || args[i + 1] == "state" || args[i + 1] == "best")) {
+            const std::string &query = args[++i];
+            batch_options.query = query == "moves" ? BatchQuery::LEGAL_MOVES
+                                  : query == "state" ? BatchQuery::GAME_STATE : BatchQuery::BEST_MOVE;
+        } else if (args[i] == "--mate" && has_value) {
+            mate_moves = std::stoi(args[++i]);
+        } else if (args[i] == "--fen" && has_value) {
+            fen = args[++i];
+        } else if (args[i] == "--shortest") {
+            shortest = true;
+        } else if (args[i] == "--bench") {
+            bench = true;
+        } else if (args[i] == "--match" && has_value) {
+            match = true;
+            match_options.games = std::stoi(args[++i]);
+        } else if (args[i] == "--movetime" && has_value) {
+            match_options.move_time = std::chrono::milliseconds(std::stoi(args[++i]));
+        } else if (args[i] == "--no-null") {
+            match_options.challenger.null_move = false;
+        } else if (args[i] == "--no-lmr") {
+            match_options.challenger.late_move_reductions = false;
+        } else if (args[i] == "--no-futility") {
+            match_options.challenger.futility = false;
+        } else if (args[i] == "--no-extensions") {
+            match_options.challenger.check_extensions = false;
+        } else if (args[i] == "--depth" && has_value) {
+            analysis_options.depth = server_options.depth = batch_options.depth = bench_options.depth = std::stoi(args[++i]);
+        } else if (args[i] == "--multipv" && has_value) {
+            analysis_options.multi_pv = std::stoi(args[++i]);
+        } else if (args[i] == "--threads" && has_value) {
+            analysis_options.threads = server_options.threads = batch_options.threads = std::stoi(args[++i]);
+        } else if (args[i] == "--nnue" && has_value) {
+            network_path = args[++i];
+        } else if (args[i] == "--explorer" && has_value) {
+            explorer_path = args[++i];
+        } else if (args[i] == "--clock" && has_value) {
+            time_control = args[++i];
+        } else if (args[i] == "--stats") {
+            stats = true;
+        } else {
+            std::cerr << "Usage: chess_tui [--clock <minutes>+<increment seconds>] [--nnue <network>] [--explorer <index>] [--stats]" << std::endl;
+            std::cerr << "       chess_tui --analyze <file> [--depth N] [--multipv N] [--threads N] [--nnue <network>] [--stats]" << std::endl;
+            std::cerr << "       chess_tui --serve <socket path> [--depth N] [--threads N] [--nnue <network>]" << std::endl;
+            std::cerr << "       chess_tui --bench [--depth N] [--nnue <network>]" << std::endl;
+            std::cerr << "       chess_tui --match <games> [--movetime <ms>] [--no-null] [--no-lmr] [--no-futility] [--no-extensions] [--nnue <network>]" << std::endl;
+            std::cerr << "       chess_tui --mate N [--fen <FEN>] [--shortest]" << std::endl;
+            std::cerr << "       chess_tui --batch <fen file> [--query moves|state|best] [--depth N] [--threads N] [--nnue <network>]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    std::unique_ptr<NnueNetwork> network;
+    if (!network_path.empty()) {
+        try {
+            network = std::make_unique<NnueNetwork>(network_path);
+        } catch (std::runtime_error &e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        analysis_options.network = server_options.network = batch_options.network = network.get();
+        bench_options.network = match_options.network = network.get();
+    }
+    if (!analyze_path.empty()) {
+        const int result = analyze(analyze_path, analysis_options);
+        if (stats) {
+            printStats();
+        }
+        return result;
+    }
+    if (bench) {
+        run_benchmark(bench_options, std::cout);
+        return EXIT_SUCCESS;
+    }
+    if (match) {
+        const MatchScore score = run_match(match_options, std::cout);
+        std::cout << "Challenger: +" << score.wins << " =" << score.draws << " -" << score.losses << std::endl;
+        return EXIT_SUCCESS;
+    }
+    if (mate_moves > 0) {
+        return solveMate(fen, mate_moves, shortest);
+    }
+    if (!batch_path.empty()) {
+        return runBatch(batch_path, batch_options);
+    }
+    if (!serve_path.empty()) {
+        return runServer(serve_path, server_options);
+    }
+
+    std::optional<GameClock> clock;
+    if (!time_control.empty()) {
+        try {
+            clock = GameClock::parse(time_control);
+        } catch (std::invalid_argument &e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::unique_ptr<OpeningIndex> explorer;
+    if (!explorer_path.empty()) {
+        try {
+            explorer = std::make_unique<OpeningIndex>(explorer_path);
+        } catch (std::runtime_error &e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
 
-    bool current_player_white = true;
+    Board board;
+    bool from_initial_position = true;
+    GameJournal journal;
+    try {
+        if (journal.recover(board)) {
+            from_initial_position = journal.startsFromInitialPosition();
+            std::cout << "Recovered unfinished game (" << board.history.size() << " moves)." << std::endl;
+        } else {
+            journal.reset(board);
+        }
+    } catch (std::runtime_error &e) {
+        std::cerr << "Cannot recover the last game: " << e.what() << std::endl;
+        board = Board();
+        journal.reset(board);
+    }
+    // Without a journal the game is only kept in memory
+    auto reportJournalError = [&journal] {
+        if (const std::string error = journal.takeWriteError(); !error.empty()) {
+            std::cerr << "Autosave disabled: " << error << std::endl;
+        }
+    };
+    reportJournalError();
+
+    std::array<std::unique_ptr<Player>, 2> players = {};
+    TranspositionTable tt(64);
+    selectGamemode(board, tt, network.get(), clock ? &*clock : nullptr, players);
+    // Against a bot undo and redo take back / replay the bot's answer as well
+    const int plies_per_turn = dynamic_cast<LocalPlayer *>(players[0].get()) ? 1 : 2;
 
     while (true) {
-        board.draw({});
+        const bool current_player_white = board.white_to_move;
+        board.draw({}, clock ? clockNotes(*clock, current_player_white) : std::array<std::string, 8>{});
 
         std::cout << "It's Player " << static_cast<uint8_t>(!current_player_white) + 1 << "'s turn! "
                 << std::endl;
+        reportJournalError();
 
-        bool check = false;
-        King &king = board.getKing(current_player_white);
-        BoardPos kingPos = board.getPos(king);
-        if (is_reachable(board, kingPos, !current_player_white)) {
-            check = true;
+        const GameState state = get_game_state(board, current_player_white);
+        if (state == GameState::CHECKMATE) {
+            std::cout << "Checkmate! Player " << static_cast<uint8_t>(current_player_white) + 1 << " Won!" << std::endl;
+            break;
+        }
+        if (state == GameState::STALEMATE) {
+            std::cout << "Stalemate! The game is a draw." << std::endl;
+            break;
+        }
+        if (board.isFiftyMoveDraw()) {
+            std::cout << "50 moves without capture or pawn move. The game is a draw." << std::endl;
+            break;
+        }
+        if (board.isRepetition()) {
+            std::cout << "Threefold repetition. The game is a draw." << std::endl;
+            break;
+        }
+        if (state == GameState::CHECK) {
             std::cout << "Check!" << std::endl;
         }
+        LegalityMasks masks = compute_legality_masks(board, current_player_white);
+        if (clock) {
+            clock->start(current_player_white);
+        }
 
+        bool retaken = false;
         while (true) {
             Move move;
             try {
@@ -145,100 +454,77 @@ int main() {
 
             if (move.store_game) {
                 saveGame(board);
+                if (from_initial_position) {
+                    saveGameRecord(board);
+                }
                 std::cout << "Saved Game." << std::endl;
                 continue;
             }
             if (move.load_game) {
-                loadGame(board);
+                try {
+                    loadGame(board);
+                } catch (std::invalid_argument &e) {
+                    std::cout << "Cannot load game: " << e.what() << std::endl;
+                    continue;
+                }
+                journal.reset(board);
+                from_initial_position = false;
                 std::cout << "Loaded Game." << std::endl;
                 board.draw({});
+                masks = compute_legality_masks(board, current_player_white);
                 continue;
             }
-
-            if (move.castling) {
-                if (check) {
-                    std::cout << "Cannot castle out of check" << std::endl;
-                    continue;
-                }
-
-                if (king.has_moved) {
-                    std::cout << "Cannot castle: King already moved" << std::endl;
-                    continue;
-                }
-
-                const bool is_short_castle = move.castling == 1;
-                Rook &rook = board.getInitialRook(current_player_white, is_short_castle);
-
-                if (rook.has_moved) {
-                    std::cout << "Cannot castle: Rook already moved" << std::endl;
+            if (move.explore) {
+                explorePosition(board, explorer.get(),
+                                clock ? clockNotes(*clock, current_player_white) : std::array<std::string, 8>{});
+                continue;
+            }
+            if (move.undo || move.redo) {
+                if (clock) {
+                    std::cout << "Moves cannot be taken back with a running clock" << std::endl;
                     continue;
                 }
-
-                int8_t rank = king.white ? 0 : 7;
-
-                if (is_short_castle) {
-                    if (board.getPiece({5, rank}) || board.getPiece({6, rank})) {
-                        std::cout << "Cannot castle: Pieces in the way" << std::endl;
-                        continue;
-                    }
-                    if (is_reachable(board, {5, rank}, !king.white) || is_reachable(board, {6, rank}, !king.white)) {
-                        std::cout << "Cannot castle through/into check" << std::endl;
-                        continue;
-                    }
-                    board.movePiece({4, rank}, {6, rank});
-                    board.movePiece({7, rank}, {5, rank});
-                    king.has_moved = true;
-                    rook.has_moved = true;
-                    break;
-                }
-
-                if (board.getPiece({2, rank}) || board.getPiece({3, rank})) {
-                    std::cout << "Cannot castle: Pieces in the way" << std::endl;
-                    continue;
+                int plies = 0;
+                while (plies < plies_per_turn && (move.undo ? journal.undo(board) : journal.redo(board))) {
+                    ++plies;
                 }
-                if (is_reachable(board, {2, rank}, !king.white) || is_reachable(board, {3, rank}, !king.white)) {
-                    std::cout << "Cannot castle through/into check" << std::endl;
+                if (plies == 0) {
+                    std::cout << (move.undo ? "Nothing to undo" : "Nothing to redo") << std::endl;
                     continue;
                 }
-                board.movePiece({4, rank}, {2, rank});
-                board.movePiece({0, rank}, {3, rank});
-                king.has_moved = true;
-                rook.has_moved = true;
+                retaken = true;
                 break;
             }
 
-            const auto &piece = board.getPiece(move.from);
-            if (!piece) {
-                std::cout << "This square is empty" << std::endl;
-                continue;
-            }
-            if (piece->white != current_player_white) {
-                std::cout << "This is not your piece" << std::endl;
-                continue;
-            }
-            auto visitor = reachable_cells_visitor(board, move.from, current_player_white);
-
-            if (std::ranges::find(visitor.reachable_cells, move.to) == visitor.reachable_cells.end()) {
-                std::cout << "This is not a valid move" << std::endl;
+            if (const char *reason = move_rejection(board, masks, move)) {
+                std::cout << reason << std::endl;
                 continue;
             }
-            auto &capturePiece = board.getPiece(move.to);
-            if (capturePiece) {
+            if (const auto &capturePiece = board.getPiece(move.to); capturePiece && !move.castling) {
                 std::cout << "You captured a " << capturePiece->getUnicode() << std::endl;
             }
-            if (capturePiece.get() == &board.getKing(!current_player_white)) {
-                std::cout << "Player " << static_cast<uint8_t>(!current_player_white) + 1 << " Won!" << std::endl;
-                return EXIT_SUCCESS;
-            }
-            capturePiece.reset();
-
-            board.movePiece(move.from, move.to);
-            board.getPiece(move.to)->has_moved = true;
+            journal.makeMove(board, move);
+            break;
+        }
+        if (retaken) {
+            continue;
+        }
+        if (clock && !clock->stop()) {
+            // The move came after the flag fell
+            board.unmakeMove();
+            board.draw({}, clockNotes(*clock, current_player_white));
+            std::cout << "Player " << static_cast<uint8_t>(!current_player_white) + 1 << " lost on time! Player "
+                    << static_cast<uint8_t>(current_player_white) + 1 << " Won!" << std::endl;
             break;
         }
-
-        current_player_white = !current_player_white;
     }
 
+    journal.clear();
+    if (from_initial_position) {
+        saveGameRecord(board);
+    }
+    if (stats) {
+        printStats();
+    }
     return 0;
 }
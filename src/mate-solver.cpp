@@ -0,0 +1,408 @@
+#include "chess-tui/mate-solver.hpp"
+
+#include <algorithm>
+
+#include "chess-tui/arena.hpp"
+#include "chess-tui/move-generator.hpp"
+#include "chess-tui/search.hpp"
+
+namespace {
+    constexpr uint32_t INFINITE_NUMBER = 1u << 30;
+
+    void set_proven(MateNode &node, const uint8_t mate_plies) {
+        node.pn = 0;
+        node.dn = INFINITE_NUMBER;
+        node.mate_plies = mate_plies;
+        node.expanded = true;
+    }
+
+    void set_disproven(MateNode &node) {
+        node.pn = INFINITE_NUMBER;
+        node.dn = 0;
+        node.expanded = true;
+    }
+
+    bool is_solved(const MateNode &node) {
+        return node.pn == 0 || node.dn == 0;
+    }
+}
+
+NodeArena::NodeArena(const size_t megabytes)
+    : node_count(std::max<size_t>(megabytes * 1024 * 1024 / sizeof(MateNode), 1)) {
+    this->nodes = std::make_unique_for_overwrite<MateNode[]>(this->node_count);
+}
+
+uint32_t NodeArena::allocate(const uint16_t move) {
+    uint32_t index;
+    if (this->free_list != NONE) {
+        index = this->free_list;
+        this->free_list = this->nodes[index].next_sibling;
+    } else if (this->untouched < this->node_count) {
+        index = this->untouched++;
+    } else {
+        return NONE;
+    }
+    ++this->used_count;
+    this->nodes[index] = {1, 1, NONE, NONE, move, 0, false};
+    return index;
+}
+
+void NodeArena::releaseList(uint32_t first) {
+    while (first != NONE) {
+        MateNode &node = this->nodes[first];
+        const uint32_t next = node.next_sibling;
+        this->releaseList(node.first_child);
+        node.next_sibling = this->free_list;
+        this->free_list = first;
+        --this->used_count;
+        first = next;
+    }
+}
+
+MateSolver::MateSolver(Board &board, const size_t megabytes) : board(board), arena(megabytes / 2), tt(megabytes / 2) {
+}
+
+MateResult MateSolver::solve(const int max_moves, const bool shortest) {
+    MateResult result;
+    result.nodes = this->nodes;
+    int plies = 2 * max_moves - 1;
+    // A node only generates moves into the list of its remaining plies, its children use the next one
+    ScratchScope scratch;
+    std::pmr::vector<MoveList> move_lists(std::max(plies, 0) + 1, scratch.resource());
+    for (MoveList &moves : move_lists) {
+        moves.reserve(MAX_MOVES);
+    }
+    this->move_lists = move_lists.data();
+    while (plies > 0 && this->prove(plies)) {
+        TTEntry entry;
+        result.nodes = this->nodes;
+        if (!this->tt.probe(this->board.hash, entry) || entry.bound != Bound::LOWER || entry.depth > plies) {
+            // No mate within plies, so the last one found is the shortest
+            if (result.outcome == MateOutcome::MATE) {
+                result.shortest = true;
+            } else {
+                result.outcome = MateOutcome::NO_MATE;
+            }
+            return result;
+        }
+        result.outcome = MateOutcome::MATE;
+        // Only the root proof bounds the mate against every defence, the line can be shorter
+        result.moves = (entry.depth + 1) / 2;
+        result.line.clear();
+        result.line_complete = this->extractLine(entry.depth, result.line);
+        if (!shortest) {
+            return result;
+        }
+        plies = entry.depth - 2;
+    }
+    // Either the budget ran out or a mate in 1 cannot get shorter
+    result.shortest = plies <= 0;
+    result.nodes = this->nodes;
+    return result;
+}
+
+bool MateSolver::prove(const int remaining) {
+    const uint32_t root = this->arena.allocate(0);
+    const bool white = this->board.white_to_move;
+    if (white) {
+        this->evaluate<Color::WHITE>(this->arena[root], remaining);
+    } else {
+        this->evaluate<Color::BLACK>(this->arena[root], remaining);
+    }
+    bool complete = true;
+    while (!is_solved(this->arena[root])) {
+        this->out_of_memory = false;
+        if (white) {
+            this->descend<Color::WHITE>(root, remaining);
+        } else {
+            this->descend<Color::BLACK>(root, remaining);
+        }
+        if (this->out_of_memory && !this->collapse(root)) {
+            complete = false;
+            break;
+        }
+    }
+    this->arena.releaseList(root);
+    return complete;
+}
+
+template<Color Us>
+void MateSolver::descend(const uint32_t index, const int remaining) {
+    MateNode &node = this->arena[index];
+    if (!node.expanded) {
+        this->expand<Us>(index, remaining);
+        return;
+    }
+    const bool attacker = remaining % 2;
+    // As long as the numbers of this node do not change, the most proving node stays below it
+    while (!is_solved(node) && !this->out_of_memory) {
+        const uint32_t pn = node.pn;
+        const uint32_t dn = node.dn;
+        uint32_t best = NodeArena::NONE;
+        for (uint32_t child = node.first_child; child != NodeArena::NONE; child = this->arena[child].next_sibling) {
+            if (best == NodeArena::NONE || (attacker ? this->arena[child].pn < this->arena[best].pn
+                                                     : this->arena[child].dn < this->arena[best].dn)) {
+                best = child;
+            }
+        }
+        this->board.makeMove<Us>(decode_move(this->arena[best].move));
+        this->descend<~Us>(best, remaining - 1);
+        this->board.unmakeMove<Us>();
+        this->update(node, attacker);
+        if (node.pn != pn || node.dn != dn) break;
+    }
+    if (is_solved(node)) {
+        this->storeResult(node, attacker, remaining);
+        this->arena.releaseList(node.first_child);
+        node.first_child = NodeArena::NONE;
+    }
+}
+
+template<Color Us>
+void MateSolver::expand(const uint32_t index, const int remaining) {
+    MateNode &node = this->arena[index];
+    const bool attacker = remaining % 2;
+    MoveList &moves = this->move_lists[remaining];
+    moves.clear();
+    if (attacker && remaining == 1) {
+        generate_checking_moves<Us>(this->board, moves);
+    } else {
+        generate_legal_moves<Us>(this->board, moves);
+    }
+
+    uint32_t last = NodeArena::NONE;
+    for (const Move &move : moves) {
+        const uint32_t child = this->arena.allocate(encode_move(move));
+        if (child == NodeArena::NONE) {
+            this->arena.releaseList(node.first_child);
+            node.first_child = NodeArena::NONE;
+            this->out_of_memory = true;
+            return;
+        }
+        if (last == NodeArena::NONE) {
+            node.first_child = child;
+        } else {
+            this->arena[last].next_sibling = child;
+        }
+        last = child;
+        this->board.makeMove<Us>(move);
+        this->evaluate<~Us>(this->arena[child], remaining - 1);
+        this->board.unmakeMove<Us>();
+    }
+    node.expanded = true;
+    this->update(node, attacker);
+    if (is_solved(node)) {
+        this->storeResult(node, attacker, remaining);
+        this->arena.releaseList(node.first_child);
+        node.first_child = NodeArena::NONE;
+    }
+}
+
+template<Color Us>
+void MateSolver::evaluate(MateNode &node, const int remaining) {
+    ++this->nodes;
+    const bool attacker = remaining % 2;
+    if (this->probeResult(node, attacker, remaining)) return;
+
+    if (!attacker && remaining == 0) {
+        if (get_game_state<Us>(this->board) == GameState::CHECKMATE) {
+            set_proven(node, 0);
+        } else {
+            set_disproven(node);
+        }
+        return;
+    }
+    MoveList &moves = this->move_lists[remaining];
+    moves.clear();
+    if (attacker && remaining == 1) {
+        generate_checking_moves<Us>(this->board, moves);
+    } else {
+        generate_legal_moves<Us>(this->board, moves);
+    }
+    if (moves.empty()) {
+        // The attacker has nothing left (no check, mated or stalemated), the defender is mated or stalemated
+        if (!attacker && get_game_state<Us>(this->board) == GameState::CHECKMATE) {
+            set_proven(node, 0);
+        } else {
+            set_disproven(node);
+        }
+        return;
+    }
+    // Positions with few replies are closer to a proof for the defender and to a disproof for the attacker
+    const auto count = static_cast<uint32_t>(moves.size());
+    node.pn = attacker ? 1 : count;
+    node.dn = attacker ? count : 1;
+}
+
+void MateSolver::update(MateNode &node, const bool attacker) {
+    uint32_t pn = attacker ? INFINITE_NUMBER : 0;
+    uint32_t dn = attacker ? 0 : INFINITE_NUMBER;
+    int mate_plies = attacker ? UINT8_MAX : 0;
+    for (uint32_t index = node.first_child; index != NodeArena::NONE; index = this->arena[index].next_sibling) {
+        const MateNode &child = this->arena[index];
+        if (attacker) {
+            pn = std::min(pn, child.pn);
+            dn = std::min(dn + child.dn, INFINITE_NUMBER);
+            if (child.pn == 0) {
+                mate_plies = std::min(mate_plies, child.mate_plies + 1);
+            }
+        } else {
+            pn = std::min(pn + child.pn, INFINITE_NUMBER);
+            dn = std::min(dn, child.dn);
+            mate_plies = std::max(mate_plies, child.mate_plies + 1);
+        }
+    }
+    node.pn = pn;
+    node.dn = dn;
+    node.mate_plies = static_cast<uint8_t>(mate_plies);
+}
+
+/*
+ * Results go into the table with the meaning of a search bound from the side to move's view:
+ * a proof is a mate score at its length in plies, a disproof bounds the score below a mate within remaining plies.
+ * The stored move is the mating move, the longest defence or the refutation.
+ */
+void MateSolver::storeResult(const MateNode &node, const bool attacker, const int remaining) {
+    uint32_t best = NodeArena::NONE;
+    for (uint32_t index = node.first_child; index != NodeArena::NONE; index = this->arena[index].next_sibling) {
+        const MateNode &child = this->arena[index];
+        if (node.pn == 0 && attacker) {
+            if (child.pn == 0 && (best == NodeArena::NONE || child.mate_plies < this->arena[best].mate_plies)) {
+                best = index;
+            }
+        } else if (node.pn == 0) {
+            if (best == NodeArena::NONE || child.mate_plies > this->arena[best].mate_plies) {
+                best = index;
+            }
+        } else if (!attacker && child.dn == 0) {
+            best = index;
+        }
+    }
+    const Move move = best == NodeArena::NONE ? Move() : decode_move(this->arena[best].move);
+    if (node.pn == 0) {
+        const int mate_score = MATE_SCORE - node.mate_plies;
+        this->tt.store(this->board.hash, move, attacker ? mate_score : -mate_score, node.mate_plies,
+                       attacker ? Bound::LOWER : Bound::UPPER);
+    } else {
+        const int bound_score = MATE_SCORE - remaining - 1;
+        this->tt.store(this->board.hash, move, attacker ? bound_score : -bound_score, remaining,
+                       attacker ? Bound::UPPER : Bound::LOWER);
+    }
+}
+
+bool MateSolver::probeResult(MateNode &node, const bool attacker, const int remaining) {
+    TTEntry entry;
+    if (!this->tt.probe(this->board.hash, entry)) return false;
+    const Bound proof = attacker ? Bound::LOWER : Bound::UPPER;
+    if (entry.bound == proof && entry.depth <= remaining) {
+        set_proven(node, static_cast<uint8_t>(entry.depth));
+        return true;
+    }
+    if (entry.bound != proof && entry.depth >= remaining) {
+        set_disproven(node);
+        return true;
+    }
+    return false;
+}
+
+bool MateSolver::collapse(const uint32_t root) {
+    // Number of nodes on every level
+    std::vector<size_t> level_sizes;
+    std::vector<std::pair<uint32_t, size_t>> stack = {{root, 0}};
+    while (!stack.empty()) {
+        const auto [index, level] = stack.back();
+        stack.pop_back();
+        if (level_sizes.size() <= level) {
+            level_sizes.resize(level + 1);
+        }
+        ++level_sizes[level];
+        for (uint32_t child = this->arena[index].first_child; child != NodeArena::NONE; child = this->arena[child].next_sibling) {
+            stack.emplace_back(child, level + 1);
+        }
+    }
+    size_t cut_level = level_sizes.size();
+    for (size_t below = 0; cut_level > 0 && below < this->arena.used() / 2;) {
+        below += level_sizes[--cut_level];
+    }
+    if (cut_level <= 1) {
+        // Only the root is left to collapse, the tree cannot shrink any further
+        return false;
+    }
+    --cut_level;
+
+    // The collapsed nodes keep their numbers, which are better estimates than a fresh evaluation
+    stack = {{root, 0}};
+    while (!stack.empty()) {
+        const auto [index, level] = stack.back();
+        stack.pop_back();
+        MateNode &node = this->arena[index];
+        if (level == cut_level) {
+            if (node.first_child != NodeArena::NONE) {
+                this->arena.releaseList(node.first_child);
+                node.first_child = NodeArena::NONE;
+                node.expanded = false;
+            }
+            continue;
+        }
+        for (uint32_t child = node.first_child; child != NodeArena::NONE; child = this->arena[child].next_sibling) {
+            stack.emplace_back(child, level + 1);
+        }
+    }
+    return true;
+}
+
+/*
+ * The attacker follows the mating moves stored with its proofs. The defender's stored move was chosen while the
+ * proofs of its other replies were still only bounds, so every reply is probed and the one the attacker needs
+ * longest against is played. Only proofs that fit into the plies left are followed, so every step shortens
+ * the mate and the line cannot wander into a repetition; a position without one is proven again.
+ */
+bool MateSolver::extractLine(const int plies, std::vector<Move> &line) {
+    auto attacker_proof = [this](const int remaining, TTEntry &entry) {
+        auto usable = [&] {
+            return entry.bound == Bound::LOWER && entry.depth <= remaining && entry.move != Move();
+        };
+        return (this->tt.probe(this->board.hash, entry) && usable())
+               || (this->prove(remaining) && this->tt.probe(this->board.hash, entry) && usable());
+    };
+    for (int remaining = plies; remaining > 0;) {
+        TTEntry entry;
+        if (!attacker_proof(remaining, entry)) break;
+        line.push_back(entry.move);
+        this->board.makeMove(entry.move);
+        remaining = entry.depth - 1;
+        if (remaining == 0) break;
+
+        Move defence;
+        int longest = -1;
+        for (const Move &reply : generate_legal_moves(this->board, this->board.white_to_move)) {
+            this->board.makeMove(reply);
+            const bool proven = attacker_proof(remaining - 1, entry);
+            this->board.unmakeMove();
+            if (!proven) {
+                longest = -1;
+                break;
+            }
+            if (entry.depth > longest) {
+                longest = entry.depth;
+                defence = reply;
+            }
+        }
+        if (longest < 0) break;
+        line.push_back(defence);
+        this->board.makeMove(defence);
+        remaining = longest;
+    }
+    const bool mated = get_game_state(this->board, this->board.white_to_move) == GameState::CHECKMATE;
+    for (size_t i = 0; i < line.size(); ++i) {
+        this->board.unmakeMove();
+    }
+    return mated;
+}
+
+template void MateSolver::descend<Color::WHITE>(uint32_t index, int remaining);
+template void MateSolver::descend<Color::BLACK>(uint32_t index, int remaining);
+template void MateSolver::expand<Color::WHITE>(uint32_t index, int remaining);
+template void MateSolver::expand<Color::BLACK>(uint32_t index, int remaining);
+template void MateSolver::evaluate<Color::WHITE>(MateNode &node, int remaining);
+template void MateSolver::evaluate<Color::BLACK>(MateNode &node, int remaining);
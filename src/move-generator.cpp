@@ -0,0 +1,528 @@
+#include "chess-tui/move-generator.hpp"
+
+#include "chess-tui/arena.hpp"
+#include "chess-tui/piece-visitor.hpp"
+
+namespace {
+    const std::array<Vector, 4> straight_directions = {Vector(1, 0), Vector(-1, 0), Vector(0, 1), Vector(0, -1)};
+    const std::array<Vector, 4> diagonal_directions = {Vector(1, 1), Vector(-1, 1), Vector(1, -1), Vector(-1, -1)};
+    const std::array<Vector, 8> knight_jumps = {
+        Vector(1, 2), Vector(2, 1), Vector(2, -1), Vector(1, -2),
+        Vector(-1, -2), Vector(-2, -1), Vector(-2, 1), Vector(-1, 2),
+    };
+    const std::array<Vector, 8> king_steps = {
+        Vector(1, 0), Vector(1, 1), Vector(0, 1), Vector(-1, 1),
+        Vector(-1, 0), Vector(-1, -1), Vector(0, -1), Vector(1, -1),
+    };
+    const std::array<char, 4> promotion_pieces = {'Q', 'R', 'B', 'N'};
+
+    bool is_slider_on(Piece &piece, const bool diagonal) {
+        const char symbol = piece.getSymbol();
+        return symbol == 'Q' || symbol == (diagonal ? 'B' : 'R');
+    }
+
+    bool has_piece(Board &board, const BoardPos &pos, const bool white, const char symbol) {
+        if (!pos.isWithinGrid()) return false;
+        const auto &piece = board.getPiece(pos);
+        return piece && piece->white == white && piece->getSymbol() == symbol;
+    }
+
+    /*
+     * Walks from the king along one direction and registers a check or a pin on that line.
+     */
+    template<Color Us>
+    void scan_line(Board &board, LegalityMasks &masks, const Vector &direction, const bool diagonal) {
+        SquareSet ray;
+        const Piece *own_blocker = nullptr;
+        BoardPos own_blocker_pos;
+        for (BoardPos pos = masks.king_pos + direction; pos.isWithinGrid(); pos += direction) {
+            ray.insert(pos);
+            const auto &piece = board.getPiece(pos);
+            if (!piece) continue;
+            if (piece->white == ColorTraits<Us>::white) {
+                if (own_blocker) return; // two own pieces in the way
+                own_blocker = piece.get();
+                own_blocker_pos = pos;
+                continue;
+            }
+            if (!is_slider_on(*piece, diagonal)) return;
+            if (own_blocker) {
+                masks.pinned.insert(own_blocker_pos);
+                masks.pin_rays[square_index(own_blocker_pos)] = ray;
+            } else {
+                masks.checkers.insert(pos);
+                masks.check_mask &= ray;
+            }
+            return;
+        }
+    }
+
+    /*
+     * Squares the piece could move to if its own king did not matter
+     */
+    template<Color Us>
+    SquareSet pseudo_targets(Board &board, const BoardPos &from, Piece &piece) {
+        using Traits = ColorTraits<Us>;
+        SquareSet targets;
+        // Returns whether a slider may continue behind dest
+        auto add_target = [&board, &targets](const BoardPos &dest) {
+            if (!dest.isWithinGrid()) return false;
+            const auto &target = board.getPiece(dest);
+            if (!target || target->white != Traits::white) {
+                targets.insert(dest);
+            }
+            return !target;
+        };
+        auto add_rays = [&add_target, &from](const std::array<Vector, 4> &directions) {
+            for (const Vector &direction : directions) {
+                for (BoardPos dest = from + direction; add_target(dest); dest += direction) {
+                }
+            }
+        };
+
+        switch (piece.getSymbol()) {
+            case 'P': {
+                const BoardPos push = from + Vector(0, Traits::pawn_dir);
+                if (!board.getPiece(push)) {
+                    targets.insert(push);
+                    const BoardPos double_push = push + Vector(0, Traits::pawn_dir);
+                    if (from.y == Traits::pawn_start_rank && !board.getPiece(double_push)) {
+                        targets.insert(double_push);
+                    }
+                }
+                for (const int8_t side : {-1, 1}) {
+                    const BoardPos capture = from + Vector(side, Traits::pawn_dir);
+                    if (!capture.isWithinGrid()) continue;
+                    const auto &target = board.getPiece(capture);
+                    if ((target && target->white != Traits::white) || capture == board.en_passant) {
+                        targets.insert(capture);
+                    }
+                }
+                break;
+            }
+            case 'N':
+                for (const Vector &jump : knight_jumps) {
+                    add_target(from + jump);
+                }
+                break;
+            case 'K':
+                for (const Vector &step : king_steps) {
+                    add_target(from + step);
+                }
+                break;
+            case 'B':
+                add_rays(diagonal_directions);
+                break;
+            case 'R':
+                add_rays(straight_directions);
+                break;
+            case 'Q':
+                add_rays(diagonal_directions);
+                add_rays(straight_directions);
+                break;
+            default:
+                break;
+        }
+        return targets;
+    }
+
+    /*
+     * Squares from which a piece of color Us would attack the enemy king, per piece type,
+     * and the own pieces that uncover a check from an own slider when they leave their line.
+     */
+    struct CheckSquares
+    {
+        SquareSet pawn;
+        SquareSet knight;
+        SquareSet bishop;
+        SquareSet rook;
+        SquareSet discoverers;
+        // For every discoverer the line from the enemy king to the slider behind it
+        std::array<SquareSet, 64> discovery_lines{};
+
+        [[nodiscard]] SquareSet of(const char symbol) const {
+            switch (symbol) {
+                case 'P': return pawn;
+                case 'N': return knight;
+                case 'B': return bishop;
+                case 'R': return rook;
+                case 'Q': return bishop | rook;
+                default: return {};
+            }
+        }
+    };
+
+    template<Color Us>
+    CheckSquares compute_check_squares(Board &board, const BoardPos &king_pos) {
+        using Traits = ColorTraits<Us>;
+        CheckSquares checks;
+        for (const int8_t side : {-1, 1}) {
+            if (const BoardPos pos = king_pos + Vector(side, -Traits::pawn_dir); pos.isWithinGrid()) {
+                checks.pawn.insert(pos);
+            }
+        }
+        for (const Vector &jump : knight_jumps) {
+            if (const BoardPos pos = king_pos + jump; pos.isWithinGrid()) {
+                checks.knight.insert(pos);
+            }
+        }
+        for (const bool diagonal : {false, true}) {
+            for (const Vector &direction : diagonal ? diagonal_directions : straight_directions) {
+                SquareSet &line_checks = diagonal ? checks.bishop : checks.rook;
+                SquareSet ray;
+                BoardPos own_blocker = {-1, -1};
+                for (BoardPos pos = king_pos + direction; pos.isWithinGrid(); pos += direction) {
+                    ray.insert(pos);
+                    if (!own_blocker.isWithinGrid()) {
+                        line_checks.insert(pos);
+                    }
+                    const auto &piece = board.getPiece(pos);
+                    if (!piece) continue;
+                    if (own_blocker.isWithinGrid() || piece->white != Traits::white) {
+                        if (own_blocker.isWithinGrid() && piece->white == Traits::white && is_slider_on(*piece, diagonal)) {
+                            checks.discoverers.insert(own_blocker);
+                            checks.discovery_lines[square_index(own_blocker)] = ray;
+                        }
+                        break;
+                    }
+                    own_blocker = pos;
+                }
+            }
+        }
+        return checks;
+    }
+
+    /*
+     * En passant removes a piece off the capture square, which the masks do not account for
+     * (the captured pawn may be the checker, or two pawns leave a rank at once). It is rare
+     * enough to simply play it and look at the king.
+     */
+    template<Color Us>
+    bool en_passant_is_legal(Board &board, const LegalityMasks &masks, const BoardPos &from) {
+        board.makeMove<Us>(Move(from, board.en_passant));
+        const bool legal = !is_attacked<~Us>(board, masks.king_pos);
+        board.unmakeMove<Us>();
+        return legal;
+    }
+}
+
+template<Color Them>
+bool is_attacked(Board &board, const BoardPos &pos, const BoardPos &ignore) {
+    using Traits = ColorTraits<Them>;
+    // Pawns attack diagonally forward, so look one rank "behind" pos from the attackers point of view
+    if (has_piece(board, pos + Vector(1, -Traits::pawn_dir), Traits::white, 'P') ||
+        has_piece(board, pos + Vector(-1, -Traits::pawn_dir), Traits::white, 'P')) {
+        return true;
+    }
+    for (const Vector &jump : knight_jumps) {
+        if (has_piece(board, pos + jump, Traits::white, 'N')) return true;
+    }
+    for (const Vector &step : king_steps) {
+        if (has_piece(board, pos + step, Traits::white, 'K')) return true;
+    }
+    for (const bool diagonal : {false, true}) {
+        for (const Vector &direction : diagonal ? diagonal_directions : straight_directions) {
+            for (BoardPos dest = pos + direction; dest.isWithinGrid(); dest += direction) {
+                if (dest == ignore) continue;
+                const auto &piece = board.getPiece(dest);
+                if (!piece) continue;
+                if (piece->white == Traits::white && is_slider_on(*piece, diagonal)) return true;
+                break;
+            }
+        }
+    }
+    return false;
+}
+
+template<Color Us>
+LegalityMasks compute_legality_masks(Board &board) {
+    using Traits = ColorTraits<Us>;
+    LegalityMasks masks;
+    masks.king_pos = board.getPos(*board.kings[Traits::white]);
+
+    for (const Vector &direction : straight_directions) {
+        scan_line<Us>(board, masks, direction, false);
+    }
+    for (const Vector &direction : diagonal_directions) {
+        scan_line<Us>(board, masks, direction, true);
+    }
+
+    for (const int8_t side : {-1, 1}) {
+        const BoardPos pos = masks.king_pos + Vector(side, Traits::pawn_dir);
+        if (has_piece(board, pos, !Traits::white, 'P')) {
+            masks.checkers.insert(pos);
+            masks.check_mask &= SquareSet(pos);
+        }
+    }
+    for (const Vector &jump : knight_jumps) {
+        const BoardPos pos = masks.king_pos + jump;
+        if (has_piece(board, pos, !Traits::white, 'N')) {
+            masks.checkers.insert(pos);
+            masks.check_mask &= SquareSet(pos);
+        }
+    }
+    if (masks.double_check()) {
+        masks.check_mask = {};
+    }
+    return masks;
+}
+
+template<Color Us>
+SquareSet legal_targets(Board &board, const LegalityMasks &masks, const BoardPos &from) {
+    const auto &piece = board.getPiece(from);
+    if (!piece) return {};
+
+    SquareSet targets = pseudo_targets<Us>(board, from, *piece);
+    if (from == masks.king_pos) {
+        for (const BoardPos &target : SquareSet(targets)) {
+            if (is_attacked<~Us>(board, target, masks.king_pos)) {
+                targets.erase(target);
+            }
+        }
+        return targets;
+    }
+
+    // In double check only the king may move
+    if (masks.check_mask.empty()) return {};
+    SquareSet en_passant;
+    if (board.en_passant.isWithinGrid() && targets.contains(board.en_passant) && piece->getSymbol() == 'P') {
+        targets.erase(board.en_passant);
+        if (en_passant_is_legal<Us>(board, masks, from)) {
+            en_passant.insert(board.en_passant);
+        }
+    }
+    targets &= masks.check_mask;
+    if (masks.pinned.contains(from)) {
+        targets &= masks.pin_rays[square_index(from)];
+    }
+    return targets | en_passant;
+}
+
+template<Color Us>
+const char *castling_rejection(Board &board, const bool short_side) {
+    using Traits = ColorTraits<Us>;
+    constexpr int8_t rank = Traits::back_rank;
+    if (is_attacked<~Us>(board, {Traits::king_from_file, rank})) {
+        return "Cannot castle out of check";
+    }
+    if (board.kings[Traits::white]->has_moved) {
+        return "Cannot castle: King already moved";
+    }
+    const Rook &rook = board.getInitialRook<Us>(short_side);
+    const int8_t rook_file = Traits::rook_from_file[short_side];
+    if (rook.has_moved || board.getPiece({rook_file, rank}).get() != &rook) {
+        return "Cannot castle: Rook already moved";
+    }
+    // Everything between king and rook has to be empty, the king must not pass an attacked square
+    const int8_t step = rook_file > Traits::king_from_file ? 1 : -1;
+    for (int8_t x = Traits::king_from_file + step; x != rook_file; x += step) {
+        if (board.getPiece({x, rank})) {
+            return "Cannot castle: Pieces in the way";
+        }
+    }
+    for (int8_t x = Traits::king_from_file + step; x != Traits::king_to_file[short_side] + step; x += step) {
+        if (is_attacked<~Us>(board, {x, rank})) {
+            return "Cannot castle through/into check";
+        }
+    }
+    return nullptr;
+}
+
+template<Color Us>
+void generate_legal_moves(Board &board, MoveList &moves) {
+    using Traits = ColorTraits<Us>;
+    const LegalityMasks masks = compute_legality_masks<Us>(board);
+    for (int8_t y = 0; y < 8; ++y) {
+        for (int8_t x = 0; x < 8; ++x) {
+            const BoardPos from = {x, y};
+            const auto &piece = board.getPiece(from);
+            if (!piece || piece->white != Traits::white) continue;
+            if (masks.double_check() && from != masks.king_pos) continue;
+            const bool pawn = piece->getSymbol() == 'P';
+            for (const BoardPos &to : legal_targets<Us>(board, masks, from)) {
+                if (pawn && to.y == Traits::promotion_rank) {
+                    for (const char promotion : promotion_pieces) {
+                        moves.emplace_back(from, to, promotion);
+                    }
+                } else {
+                    moves.emplace_back(from, to);
+                }
+            }
+        }
+    }
+    if (!masks.in_check()) {
+        for (const bool short_side : {true, false}) {
+            if (!castling_rejection<Us>(board, short_side)) {
+                moves.emplace_back(short_side ? 1 : 2);
+            }
+        }
+    }
+}
+
+template<Color Us>
+void generate_checking_moves(Board &board, MoveList &moves) {
+    using Traits = ColorTraits<Us>;
+    const BoardPos enemy_king = board.getPos(*board.kings[!Traits::white]);
+    const LegalityMasks masks = compute_legality_masks<Us>(board);
+    const CheckSquares checks = compute_check_squares<Us>(board, enemy_king);
+    // Moves whose effect on the board the check squares do not capture
+    auto gives_check = [&board, &enemy_king](const Move &move) {
+        board.makeMove<Us>(move);
+        const bool check = is_attacked<Us>(board, enemy_king);
+        board.unmakeMove<Us>();
+        return check;
+    };
+
+    for (int8_t y = 0; y < 8; ++y) {
+        for (int8_t x = 0; x < 8; ++x) {
+            const BoardPos from = {x, y};
+            const auto &piece = board.getPiece(from);
+            if (!piece || piece->white != Traits::white) continue;
+            if (masks.double_check() && from != masks.king_pos) continue;
+            const char symbol = piece->getSymbol();
+            const SquareSet targets = legal_targets<Us>(board, masks, from);
+            if (symbol == 'P' && (from.y + Traits::pawn_dir == Traits::promotion_rank || board.en_passant.isWithinGrid())) {
+                for (const BoardPos &to : targets) {
+                    if (to.y == Traits::promotion_rank) {
+                        for (const char promotion : promotion_pieces) {
+                            if (const Move move(from, to, promotion); gives_check(move)) {
+                                moves.push_back(move);
+                            }
+                        }
+                    } else if (to == board.en_passant ? gives_check(Move(from, to))
+                               : checks.pawn.contains(to) || (checks.discoverers.contains(from)
+                                                               && !checks.discovery_lines[square_index(from)].contains(to))) {
+                        moves.emplace_back(from, to);
+                    }
+                }
+                continue;
+            }
+            SquareSet checking = targets & checks.of(symbol);
+            if (checks.discoverers.contains(from)) {
+                checking |= targets - checks.discovery_lines[square_index(from)];
+            }
+            for (const BoardPos &to : checking) {
+                moves.emplace_back(from, to);
+            }
+        }
+    }
+    if (!masks.in_check()) {
+        for (const bool short_side : {true, false}) {
+            if (const Move move(short_side ? 1 : 2); !castling_rejection<Us>(board, short_side) && gives_check(move)) {
+                moves.push_back(move);
+            }
+        }
+    }
+}
+
+template<Color Us>
+GameState get_game_state(Board &board) {
+    const LegalityMasks masks = compute_legality_masks<Us>(board);
+    for (int8_t y = 0; y < 8; ++y) {
+        for (int8_t x = 0; x < 8; ++x) {
+            const BoardPos from = {x, y};
+            const auto &piece = board.getPiece(from);
+            if (!piece || piece->white != ColorTraits<Us>::white) continue;
+            if (masks.double_check() && from != masks.king_pos) continue;
+            if (!legal_targets<Us>(board, masks, from).empty()) {
+                return masks.in_check() ? GameState::CHECK : GameState::ONGOING;
+            }
+        }
+    }
+    return masks.in_check() ? GameState::CHECKMATE : GameState::STALEMATE;
+}
+
+template bool is_attacked<Color::WHITE>(Board &board, const BoardPos &pos, const BoardPos &ignore);
+template bool is_attacked<Color::BLACK>(Board &board, const BoardPos &pos, const BoardPos &ignore);
+template LegalityMasks compute_legality_masks<Color::WHITE>(Board &board);
+template LegalityMasks compute_legality_masks<Color::BLACK>(Board &board);
+template SquareSet legal_targets<Color::WHITE>(Board &board, const LegalityMasks &masks, const BoardPos &from);
+template SquareSet legal_targets<Color::BLACK>(Board &board, const LegalityMasks &masks, const BoardPos &from);
+template const char *castling_rejection<Color::WHITE>(Board &board, bool short_side);
+template const char *castling_rejection<Color::BLACK>(Board &board, bool short_side);
+template void generate_legal_moves<Color::WHITE>(Board &board, MoveList &moves);
+template void generate_legal_moves<Color::BLACK>(Board &board, MoveList &moves);
+template void generate_checking_moves<Color::WHITE>(Board &board, MoveList &moves);
+template void generate_checking_moves<Color::BLACK>(Board &board, MoveList &moves);
+template GameState get_game_state<Color::WHITE>(Board &board);
+template GameState get_game_state<Color::BLACK>(Board &board);
+
+bool is_attacked(Board &board, const BoardPos &pos, const bool by_white, const BoardPos &ignore) {
+    return by_white ? is_attacked<Color::WHITE>(board, pos, ignore) : is_attacked<Color::BLACK>(board, pos, ignore);
+}
+
+LegalityMasks compute_legality_masks(Board &board, const bool white) {
+    return white ? compute_legality_masks<Color::WHITE>(board) : compute_legality_masks<Color::BLACK>(board);
+}
+
+SquareSet legal_targets(Board &board, const LegalityMasks &masks, const BoardPos &from) {
+    const auto &piece = board.getPiece(from);
+    if (!piece) return {};
+    return piece->white ? legal_targets<Color::WHITE>(board, masks, from) : legal_targets<Color::BLACK>(board, masks, from);
+}
+
+const char *castling_rejection(Board &board, const bool white, const bool short_side) {
+    return white ? castling_rejection<Color::WHITE>(board, short_side) : castling_rejection<Color::BLACK>(board, short_side);
+}
+
+const char *move_rejection(Board &board, const LegalityMasks &masks, Move &move) {
+    const bool white = board.white_to_move;
+    if (move.castling) {
+        return castling_rejection(board, white, move.castling == 1);
+    }
+    const auto &piece = board.getPiece(move.from);
+    if (!piece) {
+        return "This square is empty";
+    }
+    if (piece->white != white) {
+        return "This is not your piece";
+    }
+    if (!legal_targets(board, masks, move.from).contains(move.to)) {
+        auto visitor = reachable_cells_visitor(board, move.from, white);
+        if (visitor.reachable_cells.contains(move.to)) {
+            return "This move would leave your king in check";
+        }
+        return "This is not a valid move";
+    }
+    // Legal pawn moves onto the first or last rank always end on the own promotion rank
+    const bool promotes = piece->getSymbol() == 'P' && (move.to.y == 0 || move.to.y == 7);
+    if (move.promotion && !promotes) {
+        return "This is not a valid move";
+    }
+    if (promotes && !move.promotion) {
+        move.promotion = 'Q';
+    }
+    return nullptr;
+}
+
+void generate_legal_moves(Board &board, const bool white, MoveList &moves) {
+    if (white) {
+        generate_legal_moves<Color::WHITE>(board, moves);
+    } else {
+        generate_legal_moves<Color::BLACK>(board, moves);
+    }
+}
+
+std::vector<Move> generate_legal_moves(Board &board, const bool white) {
+    ScratchScope scratch;
+    MoveList moves(scratch.resource());
+    moves.reserve(MAX_MOVES);
+    generate_legal_moves(board, white, moves);
+    return {moves.begin(), moves.end()};
+}
+
+std::vector<Move> generate_checking_moves(Board &board, const bool white) {
+    ScratchScope scratch;
+    MoveList moves(scratch.resource());
+    moves.reserve(MAX_MOVES);
+    if (white) {
+        generate_checking_moves<Color::WHITE>(board, moves);
+    } else {
+        generate_checking_moves<Color::BLACK>(board, moves);
+    }
+    return {moves.begin(), moves.end()};
+}
+
+GameState get_game_state(Board &board, const bool white) {
+    return white ? get_game_state<Color::WHITE>(board) : get_game_state<Color::BLACK>(board);
+}
@@ -0,0 +1,223 @@
+#include "chess-tui/nnue.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "chess-tui/zobrist.hpp"
+
+namespace {
+    struct NnueHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t l1;
+        int32_t scale;
+        int32_t output_bias;
+        uint32_t reserved[3];
+    };
+    static_assert(sizeof(NnueHeader) == 32);
+
+    constexpr size_t expected_size = sizeof(NnueHeader) + sizeof(int16_t) * (NNUE_L1 + 2 * NNUE_L1 +
+                                                                              static_cast<size_t>(NNUE_FEATURES) * NNUE_L1);
+
+    // Black looks at the board with the ranks mirrored
+    int orient(const bool perspective, const int square) {
+        return perspective ? square : square ^ 56;
+    }
+
+    int feature_index(const bool perspective, const int king_square, Piece &piece, const int square) {
+        const int piece_index = piece_type_index(piece.getSymbol()) * 2 + (piece.white != perspective);
+        return (orient(perspective, king_square) * 10 + piece_index) * 64 + orient(perspective, square);
+    }
+
+    /*
+     * dst = src + sum(adds) - sum(subs), one pass over the neurons
+     */
+    void apply_columns(const int16_t *src, int16_t *dst, const int16_t *const *adds, const int add_count,
+                       const int16_t *const *subs, const int sub_count) {
+#if defined(__AVX2__)
+        for (int i = 0; i < NNUE_L1; i += 16) {
+            __m256i values = _mm256_load_si256(reinterpret_cast<const __m256i *>(src + i));
+            for (int j = 0; j < add_count; ++j) {
+                values = _mm256_add_epi16(values, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(adds[j] + i)));
+            }
+            for (int j = 0; j < sub_count; ++j) {
+                values = _mm256_sub_epi16(values, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(subs[j] + i)));
+            }
+            _mm256_store_si256(reinterpret_cast<__m256i *>(dst + i), values);
+        }
+#else
+        for (int i = 0; i < NNUE_L1; ++i) {
+            int16_t value = src[i];
+            for (int j = 0; j < add_count; ++j) value = static_cast<int16_t>(value + adds[j][i]);
+            for (int j = 0; j < sub_count; ++j) value = static_cast<int16_t>(value - subs[j][i]);
+            dst[i] = value;
+        }
+#endif
+    }
+
+    /*
+     * sum(clamp(values, 0, NNUE_CLIP) * weights)
+     */
+    int32_t clipped_dot(const int16_t *values, const int16_t *weights) {
+#if defined(__AVX2__)
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i clip = _mm256_set1_epi16(NNUE_CLIP);
+        __m256i sum = _mm256_setzero_si256();
+        for (int i = 0; i < NNUE_L1; i += 16) {
+            __m256i clamped = _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i));
+            clamped = _mm256_max_epi16(_mm256_min_epi16(clamped, clip), zero);
+            const __m256i weight = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(clamped, weight));
+        }
+        const __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        const __m128i quarter = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+        return _mm_cvtsi128_si32(_mm_add_epi32(quarter, _mm_shuffle_epi32(quarter, 0xB1)));
+#else
+        int32_t sum = 0;
+        for (int i = 0; i < NNUE_L1; ++i) {
+            const int32_t clamped = values[i] < 0 ? 0 : values[i] > NNUE_CLIP ? NNUE_CLIP : values[i];
+            sum += clamped * weights[i];
+        }
+        return sum;
+#endif
+    }
+}
+
+NnueNetwork::NnueNetwork(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open network " + path);
+    }
+    struct stat info{};
+    if (fstat(fd, &info) < 0 || static_cast<size_t>(info.st_size) != expected_size) {
+        close(fd);
+        throw std::runtime_error("network " + path + " does not have the expected size");
+    }
+    this->mapping_size = expected_size;
+    this->mapping = mmap(nullptr, this->mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (this->mapping == MAP_FAILED) {
+        this->mapping = nullptr;
+        throw std::runtime_error("cannot map network " + path);
+    }
+    madvise(this->mapping, this->mapping_size, MADV_WILLNEED);
+
+    NnueHeader header{};
+    std::memcpy(&header, this->mapping, sizeof(header));
+    if (std::memcmp(header.magic, "CTNN", 4) != 0 || header.version != 1 || header.l1 != NNUE_L1 || header.scale <= 0) {
+        munmap(this->mapping, this->mapping_size);
+        this->mapping = nullptr;
+        throw std::runtime_error("network " + path + " has an unsupported header");
+    }
+    this->scale = header.scale;
+    this->output_bias = header.output_bias;
+    const auto *weights = reinterpret_cast<const int16_t *>(static_cast<const char *>(this->mapping) + sizeof(header));
+    this->feature_biases = weights;
+    this->output_weights = weights + NNUE_L1;
+    this->feature_weights = weights + 3 * NNUE_L1;
+}
+
+NnueNetwork::~NnueNetwork() {
+    if (this->mapping) {
+        munmap(this->mapping, this->mapping_size);
+    }
+}
+
+void NnueNetwork::refresh(Board &board, NnueAccumulator &accumulator) const {
+    this->refreshPerspective(board, accumulator, true);
+    this->refreshPerspective(board, accumulator, false);
+}
+
+void NnueNetwork::refreshPerspective(Board &board, NnueAccumulator &accumulator, const bool perspective) const {
+    const BoardPos king_pos = board.getPos(*board.kings[perspective]);
+    const int king_square = king_pos.y * 8 + king_pos.x;
+    accumulator.king_squares[perspective] = static_cast<uint8_t>(king_square);
+    int16_t *values = accumulator.values[perspective].data();
+    std::memcpy(values, this->feature_biases, sizeof(int16_t) * NNUE_L1);
+    for (int8_t y = 0; y < 8; ++y) {
+        for (int8_t x = 0; x < 8; ++x) {
+            const auto &piece = board.getPiece({x, y});
+            if (!piece || piece->getSymbol() == 'K') continue;
+            const int16_t *column = this->feature_weights +
+                                    static_cast<size_t>(feature_index(perspective, king_square, *piece, y * 8 + x)) * NNUE_L1;
+            apply_columns(values, values, &column, 1, nullptr, 0);
+        }
+    }
+}
+
+void NnueNetwork::update(Board &board, const NnueAccumulator &before, NnueAccumulator &after) const {
+    const UndoInfo &undo = board.history.back();
+    const Move &move = undo.move;
+    const bool mover = !board.white_to_move;
+
+    // Pieces entering and leaving squares, kings are not features
+    std::array<std::pair<Piece *, int>, 2> added{};
+    std::array<std::pair<Piece *, int>, 2> removed{};
+    int add_count = 0;
+    int remove_count = 0;
+    bool king_moved = false;
+    if (move.castling) {
+        const bool short_side = move.castling == 1;
+        const int rank = mover ? 0 : 7;
+        Rook &rook = board.getInitialRook(mover, short_side);
+        removed[remove_count++] = {&rook, rank * 8 + (short_side ? 7 : 0)};
+        added[add_count++] = {&rook, rank * 8 + (short_side ? 5 : 3)};
+        king_moved = true;
+    } else {
+        Piece &moved = *board.getPiece(move.to);
+        const int from = move.from.y * 8 + move.from.x;
+        const int to = move.to.y * 8 + move.to.x;
+        if (undo.promoted_pawn) {
+            removed[remove_count++] = {undo.promoted_pawn.get(), from};
+            added[add_count++] = {&moved, to};
+        } else if (moved.getSymbol() == 'K') {
+            king_moved = true;
+        } else {
+            removed[remove_count++] = {&moved, from};
+            added[add_count++] = {&moved, to};
+        }
+        if (undo.captured) {
+            const int captured_square = undo.en_passant_capture ? move.from.y * 8 + move.to.x : to;
+            removed[remove_count++] = {undo.captured.get(), captured_square};
+        }
+    }
+
+    for (const bool perspective : {true, false}) {
+        if (king_moved && perspective == mover) {
+            this->refreshPerspective(board, after, perspective);
+            continue;
+        }
+        const int king_square = before.king_squares[perspective];
+        after.king_squares[perspective] = static_cast<uint8_t>(king_square);
+        std::array<const int16_t *, 2> adds{};
+        std::array<const int16_t *, 2> subs{};
+        for (int i = 0; i < add_count; ++i) {
+            adds[i] = this->feature_weights + static_cast<size_t>(
+                          feature_index(perspective, king_square, *added[i].first, added[i].second)) * NNUE_L1;
+        }
+        for (int i = 0; i < remove_count; ++i) {
+            subs[i] = this->feature_weights + static_cast<size_t>(
+                          feature_index(perspective, king_square, *removed[i].first, removed[i].second)) * NNUE_L1;
+        }
+        apply_columns(before.values[perspective].data(), after.values[perspective].data(),
+                      adds.data(), add_count, subs.data(), remove_count);
+    }
+}
+
+int NnueNetwork::evaluate(const Board &board, const NnueAccumulator &accumulator) const {
+    const bool us = board.white_to_move;
+    const int32_t sum = this->output_bias +
+                        clipped_dot(accumulator.values[us].data(), this->output_weights) +
+                        clipped_dot(accumulator.values[!us].data(), this->output_weights + NNUE_L1);
+    return sum / this->scale;
+}
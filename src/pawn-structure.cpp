@@ -0,0 +1,110 @@
+#include "chess-tui/pawn-structure.hpp"
+
+#include <atomic>
+#include <bit>
+
+#include "chess-tui/eval-params.hpp"
+
+namespace {
+    // Counters of caches whose thread has ended
+    std::atomic<uint64_t> retired_probes = 0;
+    std::atomic<uint64_t> retired_hits = 0;
+
+    constexpr uint64_t file_mask(const int x) {
+        return uint64_t{0x0101010101010101} << x;
+    }
+
+    constexpr uint64_t neighbour_files(const int x) {
+        return (x > 0 ? file_mask(x - 1) : 0) | (x < 7 ? file_mask(x + 1) : 0);
+    }
+
+    /*
+     * The ranks in front of rank y from the point of view of the given side
+     */
+    constexpr uint64_t ranks_ahead(const bool white, const int y) {
+        if (white) return y < 7 ? ~uint64_t{0} << (8 * (y + 1)) : 0;
+        return (uint64_t{1} << (8 * y)) - 1;
+    }
+}
+
+PawnFeatures count_pawn_features(const std::array<SquareSet, 2> &pawns, const std::array<BoardPos, 2> &kings) {
+    PawnFeatures features;
+    for (const bool white : {false, true}) {
+        const SquareSet own = pawns[white];
+        const SquareSet enemy = pawns[!white];
+        for (int x = 0; x < 8; ++x) {
+            const int count = (own & SquareSet(file_mask(x))).size();
+            if (count > 1) {
+                features.doubled[white] += count - 1;
+            }
+            if (count && (own & SquareSet(neighbour_files(x))).empty()) {
+                features.isolated[white] += count;
+            }
+        }
+        for (const BoardPos &pawn : own) {
+            const SquareSet front(ranks_ahead(white, pawn.y) & (file_mask(pawn.x) | neighbour_files(pawn.x)));
+            if ((enemy & front).empty()) {
+                ++features.passed[white][white ? pawn.y : 7 - pawn.y];
+            }
+        }
+        const BoardPos &king = kings[white];
+        for (int8_t distance = 1; distance <= 2; ++distance) {
+            for (int8_t side = -1; side <= 1; ++side) {
+                const BoardPos square(static_cast<int8_t>(king.x + side),
+                                      static_cast<int8_t>(king.y + (white ? distance : -distance)));
+                if (square.isWithinGrid() && own.contains(square)) {
+                    ++features.shield[white];
+                }
+            }
+        }
+    }
+    return features;
+}
+
+int pawn_structure_score(const PawnFeatures &features) {
+    int score = 0;
+    for (const bool white : {false, true}) {
+        int side = features.doubled[white] * doubled_pawn + features.isolated[white] * isolated_pawn +
+                   features.shield[white] * pawn_shield;
+        for (int rank = 0; rank < 8; ++rank) {
+            side += features.passed[white][rank] * passed_pawn[rank];
+        }
+        score += white ? side : -side;
+    }
+    return score;
+}
+
+PawnCache::PawnCache(const size_t entries) : entries(std::bit_ceil(entries)), mask(std::bit_ceil(entries) - 1) {
+}
+
+PawnCache::~PawnCache() {
+    retired_probes += this->stats.probes;
+    retired_hits += this->stats.hits;
+}
+
+bool PawnCache::probe(const uint64_t key, int &score) {
+    ++this->stats.probes;
+    const Entry &entry = this->entries[key & this->mask];
+    if (entry.key != key) return false;
+    ++this->stats.hits;
+    score = entry.score;
+    return true;
+}
+
+void PawnCache::store(const uint64_t key, const int score) {
+    this->entries[key & this->mask] = {key, score};
+}
+
+const PawnCacheStats &PawnCache::getStats() const {
+    return this->stats;
+}
+
+PawnCache &PawnCache::local() {
+    thread_local PawnCache cache;
+    return cache;
+}
+
+PawnCacheStats PawnCache::totalStats() {
+    const PawnCacheStats &own = local().getStats();
+    return {retired_probes + own.probes, retired_hits + own.hits};
+}
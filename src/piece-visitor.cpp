@@ -4,22 +4,20 @@
 
 #include "chess-tui/piece-visitor.hpp"
 
-void remove_enemy_reachable_cells(Board &board, const bool white, std::set<BoardPos> &cells) {
+void remove_enemy_reachable_cells(Board &board, const bool white, SquareSet &cells) {
     for (int8_t x = 0; x < 8; ++x) {
         for (int8_t y = 0; y < 8; ++y) {
             BoardPos testPos = {x, y};
             const std::shared_ptr<Piece>& enemy_piece = board.getPiece(testPos);
             if (!enemy_piece || enemy_piece->white == white) continue;
             reachable_cells_visitor enemy_visitor{board, testPos, white};
-            for (auto reachable_cell : enemy_visitor.reachable_cells) {
-                cells.erase(reachable_cell);
-            }
+            cells -= enemy_visitor.reachable_cells;
         }
     }
 }
 
 bool is_reachable(Board &board, const BoardPos &pos, const bool white) {
-    std::set cells{pos};
+    SquareSet cells(pos);
     remove_enemy_reachable_cells(board, !white, cells);
     return cells.empty();
 }
@@ -34,17 +32,35 @@ reachable_cells_visitor::reachable_cells_visitor(Board &board, const BoardPos &p
 
 void reachable_cells_visitor::visit(Pawn &pawn)
 {
-    const auto base_move = Vector(0, 1);
+    if (pawn.white) {
+        this->visitPawn<Color::WHITE>(pawn);
+    } else {
+        this->visitPawn<Color::BLACK>(pawn);
+    }
+}
+
+template<Color Us>
+void reachable_cells_visitor::visitPawn(Pawn &pawn)
+{
+    using Traits = ColorTraits<Us>;
+    const auto base_move = Vector(0, Traits::pawn_dir);
 
-    this->check_reachable(pawn, pos + base_move * pawn.dir, true, false);
-    if (pos.y == pawn.start_rank)
+    const ReachableResult single_push = this->check_reachable(pawn, pos + base_move, true, false);
+    if (pos.y == Traits::pawn_start_rank && single_push == ReachableResult::MOVE)
     {
-        this->check_reachable(pawn, pos + base_move * pawn.dir * 2, true, false);
+        this->check_reachable(pawn, pos + base_move * 2, true, false);
     }
 
-    const auto base_capture = Vector(1, 1);
-    this->check_reachable(pawn, pos + base_capture * pawn.dir, false, true);
-    this->check_reachable(pawn, pos + base_capture.mirrorHorizontal() * pawn.dir, false, true);
+    const auto base_capture = Vector(1, Traits::pawn_dir);
+    for (const Vector &capture : {base_capture, base_capture.mirrorHorizontal()})
+    {
+        const BoardPos dest = pos + capture;
+        if (dest == board.en_passant) {
+            reachable_cells.insert(dest);
+        } else {
+            this->check_reachable(pawn, dest, false, true);
+        }
+    }
 }
 
 void reachable_cells_visitor::visit(Rook &rook)
@@ -121,11 +137,11 @@ const BoardPos &dest, const bool can_walk, const bool can_capture) {
     const auto &target = board.getPiece(dest);
     if (!target) {
         if (!can_walk) return ReachableResult::UNREACHABLE;
-        reachable_cells.emplace(dest);
+        reachable_cells.insert(dest);
         return ReachableResult::MOVE;
     }
     if (piece.white == target->white || !can_capture)
         return ReachableResult::UNREACHABLE;
-    reachable_cells.emplace(dest);
+    reachable_cells.insert(dest);
     return ReachableResult::CAPTURE;
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 
 #include "chess-tui/piece.hpp"
 
+#include <stdexcept>
+
 std::string Pawn::getUnicode() {
     return this->white ? "\u265F" : "\u2659";
 }
@@ -75,3 +77,15 @@ void Queen::visit(PieceVisitor &pieceVisitor) {
 char Queen::getSymbol() {
     return 'Q';
 }
+
+std::shared_ptr<Piece> createPiece(const char symbol, const bool white, const bool has_moved) {
+    switch (symbol) {
+        case 'P': return std::make_shared<Pawn>(white, has_moved);
+        case 'R': return std::make_shared<Rook>(white, has_moved);
+        case 'B': return std::make_shared<Bishop>(white, has_moved);
+        case 'N': return std::make_shared<Knight>(white, has_moved);
+        case 'K': return std::make_shared<King>(white, has_moved);
+        case 'Q': return std::make_shared<Queen>(white, has_moved);
+        default: throw std::invalid_argument("invalid piece symbol");
+    }
+}
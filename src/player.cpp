@@ -4,10 +4,11 @@
 
 #include "chess-tui/player.hpp"
 
-#include <unordered_map>
 #include <bits/this_thread_sleep.h>
+#include <stdexcept>
 
-#include "chess-tui/piece-visitor.hpp"
+#include "chess-tui/arena.hpp"
+#include "chess-tui/move-generator.hpp"
 
 using namespace std::chrono_literals;
 
@@ -27,30 +28,34 @@ Move BasicBotPlayer::requestMove() {
     std::this_thread::sleep_for(500ms);
     std::cout << "Thinking..." << std::endl;
     std::this_thread::sleep_for(1000ms);
-    std::unordered_map<std::shared_ptr<Piece>, std::set<BoardPos>> pieces;
-    for (int8_t y = 0; y < 8; ++y) {
-        for (int8_t x = 0; x < 8; ++x) {
-            const auto & piece = board.getPiece({x, y});
-            if (piece && piece->white == this->white) {
-                reachable_cells_visitor visitor{this->board, {x, y}, this->white};
-                piece->visit(visitor);
-                if (visitor.reachable_cells.empty()) continue;
-                pieces[piece] = visitor.reachable_cells;
-            }
-        }
+    ScratchScope scratch;
+    MoveList moves(scratch.resource());
+    moves.reserve(MAX_MOVES);
+    generate_legal_moves(this->board, this->white, moves);
+    // Seeded once per thread, opening the random device on every move is a system call and an allocation
+    thread_local std::mt19937_64 rng(std::random_device{}());
+    std::uniform_int_distribution<size_t> moveDistribution(0, moves.size() - 1);
+    return moves[moveDistribution(rng)];
+}
+
+SearchBotPlayer::SearchBotPlayer(Board &board, TranspositionTable &tt, const SearchLimits &limits,
+                                 const NnueNetwork *network, const GameClock *clock)
+    : board(board), tt(tt), limits(limits), network(network), clock(clock) {
+}
+
+Move SearchBotPlayer::requestMove() {
+    SearchLimits limits = this->limits;
+    if (this->clock) {
+        const TimeBudget budget = allocate_time(this->clock->remaining(this->board.white_to_move),
+                                                this->clock->getIncrement());
+        limits.depth = MAX_PLY - 1;
+        limits.soft_time = budget.soft;
+        limits.hard_time = budget.hard;
+    }
+    Searcher searcher(this->board, this->tt, this->network);
+    const SearchResult result = searcher.search(limits);
+    if (result.lines.front().moves.empty()) {
+        throw std::logic_error("no legal move to play, the game is already over");
     }
-    std::random_device dev;
-    std::mt19937_64 rng(dev());
-    std::uniform_int_distribution<size_t> pieceDistribution(0, pieces.size() - 1);
-    auto random_piece_iter = pieces.begin();
-    std::advance(random_piece_iter, pieceDistribution(rng));
-    auto [piece, cells] = *random_piece_iter;
-    BoardPos from = this->board.getPos(*piece);
-
-    std::uniform_int_distribution<size_t> cellDistribution(0, cells.size() - 1);
-    auto random_cell_iter = cells.begin();
-    std::advance(random_cell_iter, cellDistribution(rng));
-    auto to = *random_cell_iter;
-
-    return {from, to};
+    return result.lines.front().moves.front();
 }
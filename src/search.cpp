@@ -0,0 +1,405 @@
+#include "chess-tui/search.hpp"
+
+#include <algorithm>
+
+#include "chess-tui/arena.hpp"
+#include "chess-tui/eval-params.hpp"
+#include "chess-tui/evaluation.hpp"
+#include "chess-tui/move-generator.hpp"
+#include "chess-tui/zobrist.hpp"
+
+namespace {
+    // Mate scores are stored relative to the node, so they stay valid when reached via another path
+    int score_to_tt(const int score, const int ply) {
+        if (score > MATE_SCORE - MAX_PLY) return score + ply;
+        if (score < -MATE_SCORE + MAX_PLY) return score - ply;
+        return score;
+    }
+
+    int score_from_tt(const int score, const int ply) {
+        if (score > MATE_SCORE - MAX_PLY) return score - ply;
+        if (score < -MATE_SCORE + MAX_PLY) return score + ply;
+        return score;
+    }
+
+    // A root move's line while the search runs, its moves in a slot on the scratch arena
+    struct RootLine
+    {
+        int score;
+        size_t slot;
+        int length;
+    };
+
+    // En passant lands on an empty square, the captured pawn stands beside it
+    bool is_en_passant(Board &board, const Move &move) {
+        return move.to == board.en_passant && board.getPiece(move.from)->getSymbol() == 'P';
+    }
+
+    bool is_capture(Board &board, const Move &move) {
+        return !move.castling && (board.getPiece(move.to) || is_en_passant(board, move));
+    }
+
+    // Captures and promotions are ordered above every history score
+    constexpr int tactical_move_bonus = 1 << 16;
+    constexpr int history_limit = 1 << 14;
+    // Static eval margin per remaining depth below which quiet moves cannot raise alpha
+    constexpr std::array<int, 3> futility_margins = {0, 150, 300};
+
+    template<Color Us>
+    bool has_non_pawn_material(Board &board) {
+        for (const auto &row : board.grid) {
+            for (const auto &piece : row) {
+                if (piece && piece->white == ColorTraits<Us>::white && piece->getSymbol() != 'P' && piece->getSymbol() != 'K') {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+}
+
+Searcher::Searcher(Board &board, TranspositionTable &tt, const NnueNetwork *network)
+    : board(board), tt(tt), network(network) {
+}
+
+SearchResult Searcher::search(const SearchLimits &limits) {
+    // The side to move is dispatched once here, below it alternates at compile time
+    return this->board.white_to_move ? this->searchRoot<Color::WHITE>(limits) : this->searchRoot<Color::BLACK>(limits);
+}
+
+template<Color Us>
+SearchResult Searcher::searchRoot(const SearchLimits &limits) {
+    SearchResult result;
+    this->nodes = 0;
+    const auto start = std::chrono::steady_clock::now();
+    this->timed = limits.hard_time.count() > 0;
+    this->hard_deadline = start + limits.hard_time;
+    this->stopped = false;
+    this->selectivity = limits.selectivity;
+    // Keep what earlier searches learned, but let this one outweigh it
+    for (auto &side : this->history) {
+        for (auto &from : side) {
+            for (int &score : from) {
+                score /= 4;
+            }
+        }
+    }
+    // Grow the history for the deepest line here, not in the middle of the tree
+    if (const size_t needed = this->board.history.size() + MAX_PLY + 1; this->board.history.capacity() < needed) {
+        this->board.history.reserve(std::max(needed, 2 * this->board.history.capacity()));
+    }
+    // Released when the search returns, so nodes neither allocate nor keep anything
+    ScratchScope scratch;
+    std::pmr::vector<NnueAccumulator> accumulators(this->network ? MAX_PLY + 1 : 0, scratch.resource());
+    std::pmr::vector<MoveList> move_lists(MAX_PLY + 1, scratch.resource());
+    for (MoveList &moves : move_lists) {
+        moves.reserve(MAX_MOVES);
+    }
+    this->accumulators = accumulators.data();
+    this->move_lists = move_lists.data();
+    if (this->network) {
+        this->network->refresh(this->board, this->accumulators[0]);
+    }
+    // The search below starts at ply 1
+    MoveList &root_moves = move_lists[0];
+    generate_legal_moves<Us>(this->board, root_moves);
+    if (root_moves.empty()) {
+        const bool in_check = compute_legality_masks<Us>(this->board).in_check();
+        result.lines.push_back({in_check ? -MATE_SCORE : 0, {}});
+        return result;
+    }
+    TTEntry entry;
+    this->orderMoves<Us>(root_moves, this->tt.probe(this->board.hash, entry) ? entry.move : Move());
+
+    const size_t line_count = std::min<size_t>(std::max(limits.multi_pv, 1), root_moves.size());
+    // The moves of the lines of the last finished iteration and of the running one are kept in fixed slots
+    std::pmr::vector<std::array<Move, MAX_PLY>> slots(2 * line_count + 1, scratch.resource());
+    std::pmr::vector<size_t> free_slots(scratch.resource());
+    free_slots.reserve(slots.size());
+    for (size_t slot = 0; slot < slots.size(); ++slot) {
+        free_slots.push_back(slot);
+    }
+    std::pmr::vector<RootLine> completed(scratch.resource());
+    std::pmr::vector<RootLine> lines(scratch.resource());
+    completed.reserve(line_count + 1);
+    lines.reserve(line_count + 1);
+    int stable_iterations = 0;
+    for (int depth = 1; depth <= limits.depth; ++depth) {
+        // Sorted by score, a root move only has to beat the worst line that is kept
+        lines.clear();
+        for (const Move &move : root_moves) {
+            const int alpha = lines.size() < line_count ? -INFINITE_SCORE : lines.back().score;
+            this->makeMove<Us>(move, 0);
+            const int score = -this->negamax<~Us>(depth - 1, 1, -INFINITE_SCORE, -alpha);
+            this->board.unmakeMove<Us>();
+            if (this->stopped) break;
+            if (lines.size() == line_count && score <= alpha) continue;
+
+            const RootLine line{score, free_slots.back(), this->pv_length[1]};
+            free_slots.pop_back();
+            slots[line.slot][0] = move;
+            std::copy(this->pv[1].begin() + 1, this->pv[1].begin() + this->pv_length[1], slots[line.slot].begin() + 1);
+            lines.insert(std::ranges::upper_bound(lines, score, std::greater{}, &RootLine::score), line);
+            if (lines.size() > line_count) {
+                free_slots.push_back(lines.back().slot);
+                lines.pop_back();
+            }
+        }
+        if (this->stopped) break;
+
+        // Search the best lines first in the next iteration
+        for (auto line = lines.rbegin(); line != lines.rend(); ++line) {
+            const auto found = std::ranges::find(root_moves, slots[line->slot][0]);
+            std::rotate(root_moves.begin(), found, found + 1);
+        }
+        const Move &best_move = slots[lines.front().slot][0];
+        this->tt.store(this->board.hash, best_move, lines.front().score, depth, Bound::EXACT);
+        const bool first_iteration = completed.empty();
+        const int score_drop = first_iteration ? 0 : completed.front().score - lines.front().score;
+        const bool same_best = !first_iteration && slots[completed.front().slot][0] == best_move;
+        stable_iterations = same_best ? stable_iterations + 1 : 0;
+        for (const RootLine &line : completed) {
+            free_slots.push_back(line.slot);
+        }
+        completed.assign(lines.begin(), lines.end());
+        lines.clear();
+        result.depth = depth;
+        if (is_mate_score(completed.front().score) && line_count == 1) break;
+
+        if (this->timed) {
+            // Use less of the soft limit while the best move keeps being confirmed, more when the score falls
+            int percent = stable_iterations >= 4 ? 50 : stable_iterations >= 2 ? 75 : stable_iterations == 1 ? 100 : 130;
+            if (score_drop >= 50) {
+                percent += 100;
+            } else if (score_drop >= 20) {
+                percent += 50;
+            }
+            if (std::chrono::steady_clock::now() - start >= limits.soft_time * percent / 100) break;
+        }
+    }
+
+    // Only a finished iteration is trusted, unless there is nothing else
+    const std::pmr::vector<RootLine> &best_lines = completed.empty() ? lines : completed;
+    if (best_lines.empty()) {
+        result.lines.push_back({0, {root_moves.front()}});
+    }
+    result.lines.reserve(best_lines.size());
+    for (const RootLine &line : best_lines) {
+        const auto &moves = slots[line.slot];
+        result.lines.push_back({line.score, {moves.begin(), moves.begin() + line.length}});
+    }
+    result.nodes = this->nodes;
+    return result;
+}
+
+template<Color Us>
+int Searcher::negamax(int depth, const int ply, int alpha, const int beta, const bool null_allowed) {
+    this->pv_length[ply] = ply;
+    if (this->board.isFiftyMoveDraw() || this->board.isRepetition(ply)) {
+        return 0;
+    }
+    const bool in_check = is_attacked<~Us>(this->board, this->board.getPos(*this->board.kings[ColorTraits<Us>::white]));
+    // Bounded, so that a long series of checks cannot run into the ply limit
+    if (in_check && this->selectivity.check_extensions && ply < MAX_PLY / 2) {
+        ++depth;
+    }
+    if (depth <= 0 || ply >= MAX_PLY - 1) {
+        return this->quiescence<Us>(ply, alpha, beta);
+    }
+    ++this->nodes;
+    if (this->timeUp()) return 0;
+
+    TTEntry entry;
+    Move tt_move;
+    if (this->tt.probe(this->board.hash, entry)) {
+        tt_move = entry.move;
+        const int score = score_from_tt(entry.score, ply);
+        if (entry.depth >= depth && (entry.bound == Bound::EXACT ||
+                                     (entry.bound == Bound::LOWER && score >= beta) ||
+                                     (entry.bound == Bound::UPPER && score <= alpha))) {
+            return score;
+        }
+    }
+
+    int static_eval = 0;
+    if (!in_check && (this->selectivity.null_move || this->selectivity.futility)) {
+        static_eval = this->evaluatePosition(ply);
+    }
+    if (this->selectivity.null_move && null_allowed && !in_check && depth >= 3 && !is_mate_score(beta)
+        && static_eval >= beta && has_non_pawn_material<Us>(this->board)) {
+        const int reduction = depth >= 7 ? 3 : 2;
+        this->board.makeNullMove();
+        if (this->network) {
+            this->accumulators[ply + 1] = this->accumulators[ply];
+        }
+        const int score = -this->negamax<~Us>(depth - 1 - reduction, ply + 1, -beta, -beta + 1, false);
+        this->board.unmakeNullMove();
+        if (this->stopped) return 0;
+        // A mate found after passing is not a real one
+        if (score >= beta) return beta;
+    }
+
+    MoveList &moves = this->move_lists[ply];
+    moves.clear();
+    generate_legal_moves<Us>(this->board, moves);
+    if (moves.empty()) {
+        return in_check ? -MATE_SCORE + ply : 0;
+    }
+    this->orderMoves<Us>(moves, tt_move);
+
+    const bool futile = this->selectivity.futility && !in_check && depth < static_cast<int>(futility_margins.size())
+                        && !is_mate_score(alpha) && static_eval + futility_margins[depth] <= alpha;
+    const bool selective = futile || this->selectivity.late_move_reductions;
+    const BoardPos enemy_king = selective ? this->board.getPos(*this->board.kings[!ColorTraits<Us>::white]) : BoardPos{};
+
+    const int original_alpha = alpha;
+    int best_score = -INFINITE_SCORE;
+    Move best_move;
+    int moves_searched = 0;
+    for (const Move &move : moves) {
+        const bool quiet = !is_capture(this->board, move) && !move.promotion;
+        this->makeMove<Us>(move, ply);
+        const bool gives_check = selective && quiet && is_attacked<Us>(this->board, enemy_king);
+        if (futile && moves_searched > 0 && quiet && !gives_check) {
+            this->board.unmakeMove<Us>();
+            continue;
+        }
+        int reduction = 0;
+        if (this->selectivity.late_move_reductions && depth >= 3 && moves_searched >= 3 && quiet && !in_check
+            && !gives_check) {
+            // Moves that never caused a cutoff are reduced one ply more
+            const int history = this->history[ColorTraits<Us>::white][square_index(move.from)][square_index(move.to)];
+            reduction = std::min(1 + (depth >= 6) + (moves_searched >= 10) + (history == 0), depth - 1);
+        }
+        int score;
+        if (reduction > 0) {
+            score = -this->negamax<~Us>(depth - 1 - reduction, ply + 1, -alpha - 1, -alpha);
+            if (score > alpha && !this->stopped) {
+                score = -this->negamax<~Us>(depth - 1, ply + 1, -beta, -alpha);
+            }
+        } else {
+            score = -this->negamax<~Us>(depth - 1, ply + 1, -beta, -alpha);
+        }
+        this->board.unmakeMove<Us>();
+        if (this->stopped) return 0;
+        ++moves_searched;
+        if (score <= best_score) continue;
+        best_score = score;
+        best_move = move;
+        if (score > alpha) {
+            alpha = score;
+            this->updatePv(ply, move);
+            if (alpha >= beta) {
+                if (quiet) {
+                    this->updateHistory<Us>(move, depth);
+                }
+                break;
+            }
+        }
+    }
+
+    const Bound bound = best_score >= beta ? Bound::LOWER : best_score > original_alpha ? Bound::EXACT : Bound::UPPER;
+    this->tt.store(this->board.hash, best_move, score_to_tt(best_score, ply), depth, bound);
+    return best_score;
+}
+
+template<Color Us>
+int Searcher::quiescence(const int ply, int alpha, const int beta) {
+    this->pv_length[ply] = ply;
+    ++this->nodes;
+    if (this->timeUp()) return 0;
+    const int stand_pat = this->evaluatePosition(ply);
+    if (stand_pat >= beta || ply >= MAX_PLY - 1) {
+        return stand_pat;
+    }
+    alpha = std::max(alpha, stand_pat);
+
+    MoveList &moves = this->move_lists[ply];
+    moves.clear();
+    generate_legal_moves<Us>(this->board, moves);
+    std::erase_if(moves, [this](const Move &move) { return !is_capture(this->board, move) && move.promotion != 'Q'; });
+    this->orderMoves<Us>(moves, {});
+    for (const Move &move : moves) {
+        this->makeMove<Us>(move, ply);
+        const int score = -this->quiescence<~Us>(ply + 1, -beta, -alpha);
+        this->board.unmakeMove<Us>();
+        if (this->stopped) return 0;
+        if (score > alpha) {
+            alpha = score;
+            this->updatePv(ply, move);
+            if (alpha >= beta) break;
+        }
+    }
+    return alpha;
+}
+
+template<Color Us>
+void Searcher::makeMove(const Move &move, const int ply) {
+    this->board.makeMove<Us>(move);
+    if (this->network) {
+        this->network->update(this->board, this->accumulators[ply], this->accumulators[ply + 1]);
+    }
+}
+
+int Searcher::evaluatePosition(const int ply) {
+    return this->network ? this->network->evaluate(this->board, this->accumulators[ply]) : evaluate(this->board);
+}
+
+bool Searcher::timeUp() {
+    if (this->timed && !this->stopped && (this->nodes & 1023) == 0 &&
+        std::chrono::steady_clock::now() >= this->hard_deadline) {
+        this->stopped = true;
+    }
+    return this->stopped;
+}
+
+template<Color Us>
+void Searcher::orderMoves(MoveList &moves, const Move &tt_move) {
+    const auto &history = this->history[ColorTraits<Us>::white];
+    auto move_score = [this, &tt_move, &history](const Move &move) {
+        if (move == tt_move) return 1 << 20;
+        const int promotion = move.promotion ? piece_values[piece_type_index(move.promotion)] * 8 : 0;
+        if (!is_capture(this->board, move)) {
+            return promotion ? tactical_move_bonus + promotion : history[square_index(move.from)][square_index(move.to)];
+        }
+        const auto &target = this->board.getPiece(move.to);
+        const uint8_t victim = piece_type_index(target ? target->getSymbol() : 'P');
+        const uint8_t attacker = piece_type_index(this->board.getPiece(move.from)->getSymbol());
+        return tactical_move_bonus + promotion + piece_values[victim] * 8 - attacker + 1;
+    };
+    // Stable insertion sort, std::stable_sort would allocate a buffer at every node
+    std::array<int, MAX_MOVES> scores;
+    for (size_t i = 0; i < moves.size(); ++i) {
+        const Move move = moves[i];
+        const int score = move_score(move);
+        size_t j = i;
+        for (; j > 0 && scores[j - 1] < score; --j) {
+            scores[j] = scores[j - 1];
+            moves[j] = moves[j - 1];
+        }
+        scores[j] = score;
+        moves[j] = move;
+    }
+}
+
+template<Color Us>
+void Searcher::updateHistory(const Move &move, const int depth) {
+    auto &history = this->history[ColorTraits<Us>::white];
+    int &score = history[square_index(move.from)][square_index(move.to)];
+    score += depth * depth;
+    if (score >= history_limit) {
+        for (auto &from : history) {
+            for (int &value : from) {
+                value /= 2;
+            }
+        }
+    }
+}
+
+void Searcher::updatePv(const int ply, const Move &move) {
+    this->pv[ply][ply] = move;
+    for (int i = ply + 1; i < this->pv_length[ply + 1]; ++i) {
+        this->pv[ply][i] = this->pv[ply + 1][i];
+    }
+    this->pv_length[ply] = std::max(this->pv_length[ply + 1], ply + 1);
+}
@@ -0,0 +1,408 @@
+#include "chess-tui/server.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "chess-tui/move-generator.hpp"
+#include "chess-tui/player.hpp"
+
+namespace {
+    struct Session
+    {
+        int fd;
+        Board board;
+        // nullptr for a side played by the client
+        std::array<std::unique_ptr<Player>, 2> players;
+        bool started = false;
+        bool finished = false;
+        // Set while a worker searches on board, the loop must not touch it meanwhile
+        bool bot_thinking = false;
+        bool closed = false;
+        // The client shut down its side, the session is closed once its replies are out
+        bool closing = false;
+        std::string in_buffer;
+        std::string out_buffer;
+
+        explicit Session(const int fd) : fd(fd) {
+        }
+    };
+
+    struct BotResult
+    {
+        std::shared_ptr<Session> session;
+        Move move;
+    };
+
+    /*
+     * Runs bot searches. Finished moves are queued and the event loop is woken through an eventfd,
+     * so all session state is only ever modified on the loop thread.
+     */
+    class BotPool
+    {
+    public:
+        BotPool(const unsigned threads, const int wakeup_fd) : wakeup_fd(wakeup_fd) {
+            for (unsigned i = 0; i < threads; ++i) {
+                this->workers.emplace_back([this](const std::stop_token &stop) { this->run(stop); });
+            }
+        }
+
+        ~BotPool() {
+            for (auto &worker : this->workers) {
+                worker.request_stop();
+            }
+            this->jobs_changed.notify_all();
+        }
+
+        void submit(std::shared_ptr<Session> session) {
+            {
+                std::lock_guard lock(this->mutex);
+                this->jobs.push_back(std::move(session));
+            }
+            this->jobs_changed.notify_one();
+        }
+
+        std::vector<BotResult> takeResults() {
+            std::lock_guard lock(this->mutex);
+            return std::exchange(this->results, {});
+        }
+
+    private:
+        void run(const std::stop_token &stop) {
+            while (true) {
+                std::shared_ptr<Session> session;
+                {
+                    std::unique_lock lock(this->mutex);
+                    if (!this->jobs_changed.wait(lock, stop, [this] { return !this->jobs.empty(); })) return;
+                    session = std::move(this->jobs.front());
+                    this->jobs.pop_front();
+                }
+                const Move move = session->players[session->board.white_to_move]->requestMove();
+                {
+                    std::lock_guard lock(this->mutex);
+                    this->results.push_back({std::move(session), move});
+                }
+                constexpr uint64_t one = 1;
+                [[maybe_unused]] const auto written = write(this->wakeup_fd, &one, sizeof(one));
+            }
+        }
+
+        int wakeup_fd;
+        std::mutex mutex;
+        std::condition_variable_any jobs_changed;
+        std::deque<std::shared_ptr<Session>> jobs;
+        std::vector<BotResult> results;
+        std::vector<std::jthread> workers;
+    };
+
+    class Server
+    {
+    public:
+        Server(const int listen_fd, const int epoll_fd, const int wakeup_fd, const ServerOptions &options)
+            : listen_fd(listen_fd), epoll_fd(epoll_fd), wakeup_fd(wakeup_fd), options(options),
+              tt(options.hash_megabytes),
+              pool(options.threads ? options.threads : std::max(std::thread::hardware_concurrency(), 1u), wakeup_fd) {
+        }
+
+        void run() {
+            std::array<epoll_event, 256> events{};
+            while (true) {
+                const int count = epoll_wait(this->epoll_fd, events.data(), events.size(), -1);
+                if (count < 0) {
+                    if (errno == EINTR) continue;
+                    throw std::runtime_error(std::string("epoll_wait: ") + std::strerror(errno));
+                }
+                for (int i = 0; i < count; ++i) {
+                    const int fd = events[i].data.fd;
+                    if (fd == this->listen_fd) {
+                        this->accept();
+                    } else if (fd == this->wakeup_fd) {
+                        this->applyBotMoves();
+                    } else if (const auto found = this->sessions.find(fd); found != this->sessions.end()) {
+                        this->handle(found->second, events[i].events);
+                    }
+                }
+            }
+        }
+
+    private:
+        void accept() {
+            while (true) {
+                const int fd = accept4(this->listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) return;
+                epoll_event event{};
+                event.events = EPOLLIN | EPOLLRDHUP;
+                event.data.fd = fd;
+                epoll_ctl(this->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+                this->sessions.emplace(fd, std::make_shared<Session>(fd));
+            }
+        }
+
+        // Takes its own reference, closing the connection drops the one in sessions
+        void handle(const std::shared_ptr<Session> session, const uint32_t events) {
+            if (events & EPOLLOUT) {
+                this->flush(*session);
+            }
+            if ((events & EPOLLIN) && !session->closed && !session->closing) {
+                char buffer[4096];
+                ssize_t received;
+                while ((received = read(session->fd, buffer, sizeof(buffer))) > 0) {
+                    session->in_buffer.append(buffer, received);
+                }
+                // Commands sent before the end of input are still answered, as with a piped socat
+                if (received == 0) {
+                    session->closing = true;
+                }
+                size_t line_end;
+                while (!session->closed && (line_end = session->in_buffer.find('\n')) != std::string::npos) {
+                    std::string line = session->in_buffer.substr(0, line_end);
+                    session->in_buffer.erase(0, line_end + 1);
+                    if (!line.empty() && line.back() == '\r') line.pop_back();
+                    this->command(session, line);
+                }
+                if (session->in_buffer.size() > 1024) {
+                    this->close(*session);
+                    return;
+                }
+            }
+            if (events & (EPOLLHUP | EPOLLERR)) {
+                this->close(*session);
+                return;
+            }
+            if (events & EPOLLRDHUP) {
+                session->closing = true;
+            }
+            this->finish(*session);
+        }
+
+        void command(const std::shared_ptr<Session> &session, const std::string &line) {
+            if (line.empty()) return;
+            if (line == "quit") {
+                this->flush(*session);
+                this->close(*session);
+                return;
+            }
+            if (session->bot_thinking) {
+                this->send(*session, "err bot is thinking");
+                return;
+            }
+            if (line.starts_with("new")) {
+                this->startGame(session, line.substr(std::min<size_t>(line.size(), 4)));
+                return;
+            }
+            if (!session->started) {
+                this->send(*session, "err no game, use: new white|black|both");
+                return;
+            }
+            if (line == "board") {
+                std::string squares = "board ";
+                for (int8_t y = 0; y < 8; ++y) {
+                    for (int8_t x = 0; x < 8; ++x) {
+                        const auto &piece = session->board.getPiece({x, y});
+                        squares += !piece ? '.' : piece->white ? piece->getSymbol() : static_cast<char>(std::tolower(piece->getSymbol()));
+                    }
+                }
+                this->send(*session, squares);
+                return;
+            }
+            if (line == "moves") {
+                std::string reply = "moves";
+                for (const Move &move : generate_legal_moves(session->board, session->board.white_to_move)) {
+                    reply += ' ' + formatMove(move);
+                }
+                this->send(*session, reply);
+                return;
+            }
+            if (session->finished) {
+                this->send(*session, "err game is over");
+                return;
+            }
+            if (session->players[session->board.white_to_move]) {
+                this->send(*session, "err not your turn");
+                return;
+            }
+
+            Move move;
+            try {
+                move = convertMove(line);
+            } catch (std::invalid_argument &e) {
+                this->send(*session, std::string("err ") + e.what());
+                return;
+            }
+            // Bare pawn moves to the last rank promote to a queen, like in the terminal
+            if (!move.castling && !move.promotion && move.from.isWithinGrid() && move.to.isWithinGrid()) {
+                const auto &piece = session->board.getPiece(move.from);
+                if (piece && piece->getSymbol() == 'P' && (move.to.y == 0 || move.to.y == 7)) {
+                    move.promotion = 'Q';
+                }
+            }
+            const std::vector<Move> legal_moves = generate_legal_moves(session->board, session->board.white_to_move);
+            if (move.isCommand() || std::ranges::find(legal_moves, move) == legal_moves.end()) {
+                this->send(*session, "err illegal move");
+                return;
+            }
+            session->board.makeMove(move);
+            this->send(*session, "ok " + formatMove(move));
+            this->advance(session);
+        }
+
+        void startGame(const std::shared_ptr<Session> &session, const std::string &side) {
+            if (side != "white" && side != "black" && side != "both") {
+                this->send(*session, "err use: new white|black|both");
+                return;
+            }
+            session->board = Board();
+            session->players = {};
+            const SearchLimits limits{.depth = this->options.depth, .multi_pv = 1};
+            if (side == "white") {
+                session->players[0] = std::make_unique<SearchBotPlayer>(session->board, this->tt, limits,
+                                                                          this->options.network);
+            } else if (side == "black") {
+                session->players[1] = std::make_unique<SearchBotPlayer>(session->board, this->tt, limits,
+                                                                          this->options.network);
+            }
+            session->started = true;
+            session->finished = false;
+            this->send(*session, "ok new " + side);
+            this->advance(session);
+        }
+
+        /*
+         * Reports the end of the game or hands the position to the bot if it is to move
+         */
+        void advance(const std::shared_ptr<Session> &session) {
+            Board &board = session->board;
+            const GameState state = get_game_state(board, board.white_to_move);
+            const char *reason = nullptr;
+            if (state == GameState::CHECKMATE) reason = board.white_to_move ? "0-1 checkmate" : "1-0 checkmate";
+            else if (state == GameState::STALEMATE) reason = "1/2-1/2 stalemate";
+            else if (board.isFiftyMoveDraw()) reason = "1/2-1/2 fifty-move-rule";
+            else if (board.isRepetition()) reason = "1/2-1/2 repetition";
+            if (reason) {
+                session->finished = true;
+                this->send(*session, std::string("end ") + reason);
+                return;
+            }
+            if (session->players[board.white_to_move]) {
+                session->bot_thinking = true;
+                this->pool.submit(session);
+            }
+        }
+
+        void applyBotMoves() {
+            uint64_t counter;
+            [[maybe_unused]] const auto read_bytes = read(this->wakeup_fd, &counter, sizeof(counter));
+            for (auto &[session, move] : this->pool.takeResults()) {
+                session->bot_thinking = false;
+                if (session->closed) continue;
+                session->board.makeMove(move);
+                this->send(*session, "move " + formatMove(move));
+                this->advance(session);
+                this->finish(*session);
+            }
+        }
+
+        void send(Session &session, const std::string &line) {
+            if (session.closed) return;
+            session.out_buffer += line;
+            session.out_buffer += '\n';
+            this->flush(session);
+        }
+
+        void flush(Session &session) {
+            while (!session.out_buffer.empty()) {
+                const ssize_t sent = ::send(session.fd, session.out_buffer.data(), session.out_buffer.size(), MSG_NOSIGNAL);
+                if (sent < 0) {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                    this->close(session);
+                    return;
+                }
+                session.out_buffer.erase(0, sent);
+            }
+            this->watch(session);
+        }
+
+        // Only waits for writability while something is pending, and for input until the client shut down its side
+        void watch(const Session &session) {
+            epoll_event event{};
+            event.events = (session.closing ? 0u : static_cast<uint32_t>(EPOLLIN | EPOLLRDHUP))
+                           | (session.out_buffer.empty() ? 0u : static_cast<uint32_t>(EPOLLOUT));
+            event.data.fd = session.fd;
+            epoll_ctl(this->epoll_fd, EPOLL_CTL_MOD, session.fd, &event);
+        }
+
+        /*
+         * Closes a closing session once everything is sent and no bot move is left to come
+         */
+        void finish(Session &session) {
+            if (session.closed || !session.closing) return;
+            if (session.out_buffer.empty() && !session.bot_thinking) {
+                this->close(session);
+            } else {
+                this->watch(session);
+            }
+        }
+
+        void close(Session &session) {
+            if (session.closed) return;
+            session.closed = true;
+            epoll_ctl(this->epoll_fd, EPOLL_CTL_DEL, session.fd, nullptr);
+            ::close(session.fd);
+            // A worker still searching keeps its own reference until the result is dropped
+            this->sessions.erase(session.fd);
+        }
+
+        int listen_fd;
+        int epoll_fd;
+        int wakeup_fd;
+        ServerOptions options;
+        TranspositionTable tt;
+        std::unordered_map<int, std::shared_ptr<Session>> sessions;
+        BotPool pool;
+    };
+}
+
+int runServer(const std::string &socket_path, const ServerOptions &options) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    const int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(socket_path.c_str());
+    if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+        listen(listen_fd, SOMAXCONN) < 0) {
+        std::cerr << "Cannot listen on " << socket_path << ": " << std::strerror(errno) << std::endl;
+        return EXIT_FAILURE;
+    }
+    const int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    const int wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    for (const int fd : {listen_fd, wakeup_fd}) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    std::cout << "Serving on " << socket_path << std::endl;
+    Server server(listen_fd, epoll_fd, wakeup_fd, options);
+    server.run();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,73 @@
+#include "chess-tui/transposition-table.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#include "chess-tui/move-generator.hpp"
+
+namespace {
+    constexpr std::array<char, 4> promotion_pieces = {'N', 'B', 'R', 'Q'};
+}
+
+uint16_t encode_move(const Move &move) {
+    if (move.castling) {
+        return static_cast<uint16_t>(2 << 12 | move.castling);
+    }
+    uint16_t kind = 1;
+    if (move.promotion) {
+        kind = static_cast<uint16_t>(3 + (std::ranges::find(promotion_pieces, move.promotion) - promotion_pieces.begin()));
+    }
+    return static_cast<uint16_t>(kind << 12 | square_index(move.from) | square_index(move.to) << 6);
+}
+
+Move decode_move(const uint16_t encoded) {
+    const uint16_t kind = encoded >> 12;
+    if (kind == 0) {
+        return {};
+    }
+    if (kind == 2) {
+        return Move(encoded & 0x3);
+    }
+    const uint8_t from = encoded & 0x3F;
+    const uint8_t to = encoded >> 6 & 0x3F;
+    return {{static_cast<int8_t>(from % 8), static_cast<int8_t>(from / 8)},
+            {static_cast<int8_t>(to % 8), static_cast<int8_t>(to / 8)},
+            kind >= 3 ? promotion_pieces[kind - 3] : '\0'};
+}
+
+TranspositionTable::TranspositionTable(const size_t megabytes) {
+    const size_t count = std::bit_floor(std::max<size_t>(megabytes * 1024 * 1024 / sizeof(Slot), 1));
+    this->slots = std::make_unique<Slot[]>(count);
+    this->mask = count - 1;
+}
+
+bool TranspositionTable::probe(const uint64_t key, TTEntry &entry) const {
+    const Slot &slot = this->slots[key & this->mask];
+    const uint64_t data = slot.data.load(std::memory_order_relaxed);
+    if ((slot.checked_key.load(std::memory_order_relaxed) ^ data) != key || data == 0) {
+        return false;
+    }
+    entry.move = decode_move(static_cast<uint16_t>(data));
+    entry.score = static_cast<int16_t>(data >> 16);
+    entry.depth = static_cast<uint8_t>(data >> 32);
+    entry.bound = static_cast<Bound>(data >> 40 & 0x3);
+    return true;
+}
+
+void TranspositionTable::store(const uint64_t key, const Move &move, const int score, const int depth,
+                               const Bound bound) {
+    Slot &slot = this->slots[key & this->mask];
+    const uint64_t data = encode_move(move)
+                          | static_cast<uint64_t>(static_cast<uint16_t>(score)) << 16
+                          | static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 32
+                          | static_cast<uint64_t>(bound) << 40;
+    slot.checked_key.store(key ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i <= this->mask; ++i) {
+        this->slots[i].checked_key.store(0, std::memory_order_relaxed);
+        this->slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
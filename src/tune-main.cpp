@@ -0,0 +1,56 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "chess-tui/tuner.hpp"
+
+int main(int argc, char *argv[]) {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+    std::string positions_path;
+    std::string output_path = "eval-params.hpp";
+    TuneOptions options;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const bool has_value = i + 1 < args.size();
+        if (args[i] == "--output" && has_value) {
+            output_path = args[++i];
+        } else if (args[i] == "--epochs" && has_value) {
+            options.epochs = std::stoi(args[++i]);
+        } else if (args[i] == "--rate" && has_value) {
+            options.learning_rate = std::stod(args[++i]);
+        } else if (args[i] == "--threads" && has_value) {
+            options.threads = std::stoi(args[++i]);
+        } else if (positions_path.empty() && !args[i].starts_with("--")) {
+            positions_path = args[i];
+        } else {
+            positions_path.clear();
+            break;
+        }
+    }
+    if (positions_path.empty()) {
+        std::cerr << "Usage: chess_tune <positions> [--output eval-params.hpp] [--epochs N] [--rate R] [--threads N]"
+                << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream fin(positions_path);
+    if (!fin) {
+        std::cerr << "Cannot open " << positions_path << std::endl;
+        return EXIT_FAILURE;
+    }
+    try {
+        const std::vector<TunePosition> positions = read_labeled_positions(fin);
+        const TuneParams params = tune(positions, default_tune_params(), options, std::cout);
+        std::ofstream fout(output_path);
+        write_eval_params(params, fout);
+        if (!fout) {
+            std::cerr << "Cannot write " << output_path << std::endl;
+            return EXIT_FAILURE;
+        }
+    } catch (std::invalid_argument &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Wrote " << output_path << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,314 @@
+#include "chess-tui/tuner.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+
+#include "chess-tui/eval-params.hpp"
+#include "chess-tui/pawn-structure.hpp"
+#include "chess-tui/zobrist.hpp"
+
+namespace {
+    constexpr std::array<const char *, 6> piece_names = {"Pawn", "Knight", "Bishop", "Rook", "Queen", "King"};
+
+    int pst_index(const int type, const int square) {
+        return 6 + type * 64 + square;
+    }
+
+    // The pawn structure parameters in the order of TunePosition::pawn_terms
+    constexpr int doubled_index = 6 + 6 * 64;
+    constexpr int isolated_index = doubled_index + 1;
+    constexpr int passed_index = doubled_index + 2;
+    constexpr int shield_index = passed_index + 8;
+
+    /*
+     * Splits [0, count) into one contiguous range per worker and runs work(begin, end, worker) on each
+     */
+    template<typename Work>
+    void for_each_chunk(const size_t count, const unsigned workers, const Work &work) {
+        std::vector<std::jthread> pool;
+        for (unsigned i = 0; i < workers; ++i) {
+            pool.emplace_back(work, count * i / workers, count * (i + 1) / workers, i);
+        }
+    }
+
+    template<typename Visit>
+    void for_each_piece(const TunePosition &position, const Visit &visit) {
+        uint64_t occupancy = position.occupancy;
+        for (int i = 0; occupancy; ++i, occupancy &= occupancy - 1) {
+            const uint8_t piece = position.pieces[i / 2] >> (i % 2 * 4) & 0xF;
+            visit(std::countr_zero(occupancy), static_cast<bool>(piece >> 3), piece & 7);
+        }
+    }
+
+    void count_pawn_terms(TunePosition &position) {
+        std::array<SquareSet, 2> pawns;
+        std::array<BoardPos, 2> kings;
+        for_each_piece(position, [&](const int square, const bool white, const int type) {
+            if (type == 0) {
+                pawns[white].insert(square_pos(square));
+            } else if (type == 5) {
+                kings[white] = square_pos(square);
+            }
+        });
+        const PawnFeatures features = count_pawn_features(pawns, kings);
+        auto difference = [](const std::array<int, 2> &counts) { return static_cast<int8_t>(counts[1] - counts[0]); };
+        position.pawn_terms[0] = difference(features.doubled);
+        position.pawn_terms[1] = difference(features.isolated);
+        for (int rank = 0; rank < 8; ++rank) {
+            position.pawn_terms[2 + rank] = difference({features.passed[0][rank], features.passed[1][rank]});
+        }
+        position.pawn_terms[10] = difference(features.shield);
+    }
+
+    /*
+     * Calls visit(parameter index, coefficient) for every parameter the position depends on,
+     * the evaluation is the sum of coefficient * parameter
+     */
+    template<typename Visit>
+    void for_each_term(const TunePosition &position, const Visit &visit) {
+        for_each_piece(position, [&visit](const int square, const bool white, const int type) {
+            const double sign = white ? 1 : -1;
+            visit(type, sign);
+            visit(pst_index(type, white ? square : square ^ 56), sign);
+        });
+        for (int i = 0; i < 11; ++i) {
+            if (position.pawn_terms[i]) {
+                visit(doubled_index + i, position.pawn_terms[i]);
+            }
+        }
+    }
+
+    double evaluate(const TunePosition &position, const TuneParams &params) {
+        double score = 0;
+        for_each_term(position, [&](const int index, const double sign) { score += sign * params[index]; });
+        return score;
+    }
+
+    double sigmoid(const double k, const double score) {
+        return 1 / (1 + std::exp(-k * score));
+    }
+
+    double mean_loss(const std::vector<TunePosition> &positions, const TuneParams &params, const double k,
+                     const unsigned workers) {
+        std::vector<double> sums(workers);
+        for_each_chunk(positions.size(), workers, [&](const size_t begin, const size_t end, const unsigned worker) {
+            double sum = 0;
+            for (size_t i = begin; i < end; ++i) {
+                const double error = positions[i].result / 2.0 - sigmoid(k, evaluate(positions[i], params));
+                sum += error * error;
+            }
+            sums[worker] = sum;
+        });
+        double total = 0;
+        for (const double sum : sums) total += sum;
+        return total / static_cast<double>(positions.size());
+    }
+
+    /*
+     * Scaling constant of the sigmoid that best explains the results with the starting parameters
+     */
+    double fit_k(const std::vector<TunePosition> &positions, const TuneParams &params, const unsigned workers) {
+        double low = 0;
+        double high = 0.05;
+        for (int i = 0; i < 40; ++i) {
+            const double a = low + (high - low) / 3;
+            const double b = high - (high - low) / 3;
+            if (mean_loss(positions, params, a, workers) < mean_loss(positions, params, b, workers)) {
+                high = b;
+            } else {
+                low = a;
+            }
+        }
+        return (low + high) / 2;
+    }
+}
+
+TunePosition parse_labeled_position(const std::string &line) {
+    const size_t placement_end = line.find(' ');
+    if (placement_end == std::string::npos) {
+        throw std::invalid_argument("missing result: " + line);
+    }
+
+    std::array<uint8_t, 64> board{};
+    std::array<bool, 64> occupied{};
+    int x = 0;
+    int y = 7;
+    for (size_t i = 0; i < placement_end; ++i) {
+        const char c = line[i];
+        if (c == '/') {
+            --y;
+            x = 0;
+        } else if (c >= '1' && c <= '8') {
+            x += c - '0';
+        } else {
+            const char symbol = static_cast<char>(std::toupper(c));
+            if (std::string_view("PNBRQK").find(symbol) == std::string_view::npos || x > 7 || y < 0) {
+                throw std::invalid_argument("invalid FEN: " + line);
+            }
+            board[y * 8 + x] = static_cast<uint8_t>((symbol == c) << 3 | piece_type_index(symbol));
+            occupied[y * 8 + x] = true;
+            ++x;
+        }
+        if (x > 8 || y < 0) {
+            throw std::invalid_argument("invalid FEN: " + line);
+        }
+    }
+
+    TunePosition position;
+    int count = 0;
+    for (int square = 0; square < 64; ++square) {
+        if (!occupied[square]) continue;
+        if (count == 32) {
+            throw std::invalid_argument("more than 32 pieces: " + line);
+        }
+        position.occupancy |= uint64_t{1} << square;
+        position.pieces[count / 2] |= board[square] << (count % 2 * 4);
+        ++count;
+    }
+    count_pawn_terms(position);
+
+    const std::string_view rest = std::string_view(line).substr(placement_end);
+    if (rest.find("1/2-1/2") != std::string_view::npos || rest.find("0.5") != std::string_view::npos) {
+        position.result = 1;
+    } else if (rest.find("1-0") != std::string_view::npos || rest.find("1.0") != std::string_view::npos) {
+        position.result = 2;
+    } else if (rest.find("0-1") != std::string_view::npos || rest.find("0.0") != std::string_view::npos) {
+        position.result = 0;
+    } else {
+        throw std::invalid_argument("missing result: " + line);
+    }
+    return position;
+}
+
+std::vector<TunePosition> read_labeled_positions(std::istream &in) {
+    std::vector<TunePosition> positions;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line == "\r") continue;
+        positions.push_back(parse_labeled_position(line));
+    }
+    return positions;
+}
+
+TuneParams default_tune_params() {
+    TuneParams params{};
+    for (int type = 0; type < 6; ++type) {
+        params[type] = piece_values[type];
+        for (int square = 0; square < 64; ++square) {
+            params[pst_index(type, square)] = piece_square_tables[type][square];
+        }
+    }
+    params[doubled_index] = doubled_pawn;
+    params[isolated_index] = isolated_pawn;
+    for (int rank = 0; rank < 8; ++rank) {
+        params[passed_index + rank] = passed_pawn[rank];
+    }
+    params[shield_index] = pawn_shield;
+    return params;
+}
+
+TuneParams tune(const std::vector<TunePosition> &positions, const TuneParams &start, const TuneOptions &options,
+                std::ostream &log) {
+    if (positions.empty()) {
+        throw std::invalid_argument("no positions to tune on");
+    }
+    const unsigned workers = std::min<size_t>(
+        options.threads ? options.threads : std::max(std::thread::hardware_concurrency(), 1u), positions.size());
+    const auto start_time = std::chrono::steady_clock::now();
+    const double k = fit_k(positions, start, workers);
+    log << positions.size() << " positions, K = " << k << ", loss " << mean_loss(positions, start, k, workers)
+            << std::endl;
+
+    TuneParams params = start;
+    TuneParams momentum{};
+    TuneParams velocity{};
+    constexpr double beta1 = 0.9;
+    constexpr double beta2 = 0.999;
+    std::vector<TuneParams> gradients(workers);
+    std::vector<double> losses(workers);
+    for (int epoch = 1; epoch <= options.epochs; ++epoch) {
+        for_each_chunk(positions.size(), workers, [&](const size_t begin, const size_t end, const unsigned worker) {
+            // Accumulate locally, the shared vectors are only written once per worker
+            TuneParams gradient{};
+            double loss = 0;
+            for (size_t i = begin; i < end; ++i) {
+                const double predicted = sigmoid(k, evaluate(positions[i], params));
+                const double error = positions[i].result / 2.0 - predicted;
+                loss += error * error;
+                const double slope = -2 * error * predicted * (1 - predicted) * k;
+                for_each_term(positions[i], [&](const int index, const double sign) { gradient[index] += sign * slope; });
+            }
+            gradients[worker] = gradient;
+            losses[worker] = loss;
+        });
+
+        double loss = 0;
+        for (unsigned worker = 0; worker < workers; ++worker) {
+            loss += losses[worker];
+        }
+        const double correction1 = 1 - std::pow(beta1, epoch);
+        const double correction2 = 1 - std::pow(beta2, epoch);
+        for (int i = 0; i < TUNE_PARAM_COUNT; ++i) {
+            double gradient = 0;
+            for (const TuneParams &worker_gradient : gradients) {
+                gradient += worker_gradient[i];
+            }
+            gradient /= static_cast<double>(positions.size());
+            momentum[i] = beta1 * momentum[i] + (1 - beta1) * gradient;
+            velocity[i] = beta2 * velocity[i] + (1 - beta2) * gradient * gradient;
+            params[i] -= options.learning_rate * (momentum[i] / correction1) / (std::sqrt(velocity[i] / correction2) + 1e-12);
+        }
+        if (epoch % 10 == 0 || epoch == options.epochs) {
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start_time);
+            log << "epoch " << epoch << ", loss " << loss / static_cast<double>(positions.size()) << ", "
+                    << elapsed.count() << " ms" << std::endl;
+        }
+    }
+    return params;
+}
+
+void write_eval_params(const TuneParams &params, std::ostream &out) {
+    auto rounded = [&params](const int index) { return static_cast<int>(std::lround(params[index])); };
+    out << "#ifndef CHESS_TUI_EVAL_PARAMS_HPP\n"
+            "#define CHESS_TUI_EVAL_PARAMS_HPP\n"
+            "#include <array>\n"
+            "\n"
+            "/*\n"
+            " * Evaluation weights in centipawns, indexed by piece_type_index (P, N, B, R, Q, K).\n"
+            " * Piece square tables are indexed y * 8 + x from white's point of view (a1 first),\n"
+            " * black pieces look them up with the rank mirrored.\n"
+            " * Generated by chess_tune.\n"
+            " */\n"
+            "\n"
+            "inline constexpr std::array<int, 6> piece_values = {";
+    for (int type = 0; type < 6; ++type) {
+        out << (type ? ", " : "") << rounded(type);
+    }
+    out << "};\n\n// Pawn structure, per pawn (see PawnFeatures)\n"
+            "inline constexpr int doubled_pawn = " << rounded(doubled_index) << ";\n"
+            "inline constexpr int isolated_pawn = " << rounded(isolated_index) << ";\n"
+            "inline constexpr std::array<int, 8> passed_pawn = {";
+    for (int rank = 0; rank < 8; ++rank) {
+        out << (rank ? ", " : "") << rounded(passed_index + rank);
+    }
+    out << "};\ninline constexpr int pawn_shield = " << rounded(shield_index) << ";\n"
+            "\ninline constexpr std::array<std::array<int, 64>, 6> piece_square_tables = {{\n";
+    for (int type = 0; type < 6; ++type) {
+        out << "        // " << piece_names[type] << "\n        {\n";
+        for (int y = 0; y < 8; ++y) {
+            out << "            ";
+            for (int x = 0; x < 8; ++x) {
+                out << (x ? ", " : "") << std::setw(4) << rounded(pst_index(type, y * 8 + x));
+            }
+            out << ",\n";
+        }
+        out << "        },\n";
+    }
+    out << "}};\n\n#endif //CHESS_TUI_EVAL_PARAMS_HPP\n";
+}
@@ -4,7 +4,7 @@
 
 #include "chess-tui/vector.hpp"
 
-#include <set>
+#include <algorithm>
 
 Vector::Vector(const int8_t x, const int8_t y) : x(x), y(y) {
 
@@ -61,11 +61,11 @@ Vector Vector::rotate90(const bool clockwise) const {
 /*
  * Treat Vector as a shape and return all possible Vectors with the same shape.
  */
-std::set<Vector> Vector::getAllPossibleTransforms() const {
-    std::set<Vector> result;
+VectorList Vector::getAllPossibleTransforms() const {
+    VectorList result;
     for (const Vector &mirrored : {*this, this->mirrorHorizontal(), this->mirrorVertical(), this->mirrorVertical().mirrorHorizontal()}) {
-        result.emplace(mirrored);
-        result.emplace(mirrored.rotate90(true));
+        result.insert(mirrored);
+        result.insert(mirrored.rotate90(true));
     }
     return result;
 }
@@ -79,3 +79,8 @@ bool Vector::operator<(const Vector &other) const {
         return x < other.x;
     return y < other.y;
 }
+
+void VectorList::insert(const Vector &vector) {
+    if (std::find(this->begin(), this->end(), vector) != this->end()) return;
+    this->vectors[this->count++] = vector;
+}
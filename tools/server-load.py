@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""Load test for chess_tui --serve.
+
+Opens many idle game sessions, then plays human moves on one more session and reports
+the round trip from sending a move to its "ok". With --pid the resident memory of the
+server is read from /proc before and after the idle sessions are opened.
+
+    ./chess_tui --serve /tmp/chess.sock &
+    tools/server-load.py /tmp/chess.sock --sessions 3000 --pid $!
+"""
+import argparse
+import resource
+import socket
+import statistics
+import time
+
+# Knights out and back twice, the last move repeats the start position a third time
+SHUFFLE = ["g1f3", "g8f6", "f3g1", "f6g8"] * 2
+
+
+def rss_kib(pid):
+    with open(f"/proc/{pid}/status") as status:
+        for line in status:
+            if line.startswith("VmRSS:"):
+                return int(line.split()[1])
+    raise RuntimeError(f"no VmRSS for process {pid}")
+
+
+class Session:
+    def __init__(self, path):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.connect(path)
+        self.reader = self.sock.makefile("r", encoding="ascii", newline="\n")
+
+    def request(self, line):
+        self.sock.sendall((line + "\n").encode("ascii"))
+        return self.reader.readline().rstrip("\n")
+
+    def expect(self, line, prefix):
+        reply = self.request(line)
+        if not reply.startswith(prefix):
+            raise RuntimeError(f"{line!r} answered with {reply!r}")
+        return reply
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("socket")
+    parser.add_argument("--sessions", type=int, default=1000, help="idle sessions held open")
+    parser.add_argument("--moves", type=int, default=10000, help="timed human moves")
+    parser.add_argument("--pid", type=int, help="server process, to report its memory")
+    args = parser.parse_args()
+
+    # Every session is one file descriptor here as well
+    soft, hard = resource.getrlimit(resource.RLIMIT_NOFILE)
+    if soft < args.sessions + 16:
+        resource.setrlimit(resource.RLIMIT_NOFILE, (min(hard, args.sessions + 16), hard))
+
+    before = rss_kib(args.pid) if args.pid else None
+    idle = []
+    for _ in range(args.sessions):
+        session = Session(args.socket)
+        session.expect("new both", "ok new")
+        idle.append(session)
+    if args.pid:
+        after = rss_kib(args.pid)
+        print(f"{args.sessions} idle sessions: server RSS {before / 1024:.1f} -> {after / 1024:.1f} MiB "
+              f"({(after - before) / max(args.sessions, 1):.2f} KiB per session)")
+
+    player = Session(args.socket)
+    player.expect("new both", "ok new")
+    round_trips = []
+    for i in range(args.moves):
+        move = SHUFFLE[i % len(SHUFFLE)]
+        start = time.perf_counter_ns()
+        player.expect(move, "ok")
+        round_trips.append(time.perf_counter_ns() - start)
+        if i % len(SHUFFLE) == len(SHUFFLE) - 1:
+            player.reader.readline()  # end 1/2-1/2 repetition
+            player.expect("new both", "ok new")
+    round_trips.sort()
+    print(f"{args.moves} moves: median {statistics.median(round_trips) / 1000:.1f} us, "
+          f"p99 {round_trips[len(round_trips) * 99 // 100] / 1000:.1f} us")
+
+    for session in idle + [player]:
+        session.sock.close()
+
+
+if __name__ == "__main__":
+    main()